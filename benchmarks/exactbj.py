@@ -59,42 +59,16 @@ def Mn_plus_distribution(n, x):
     return 1.0 - crossprob.ecdf1_new_b(b_bounds)
     #return 1.0 - crossprob.ecdf2(b_bounds, [1]*len(b_bounds), True)
 
-N_BINARY_SEARCH_STEPS_MAX = 110 
 EPSILON = 1e-11
 
 def inverse_Mn_plus(n, alpha, debug_prints):
     """
-    Binary search for x such that
+    Finds x such that
         Mn_plus_distribution(n,x) = alpha
     """
-    low = 0.0
-    high = 1.0 
-    last_range = None
-    for i in range(N_BINARY_SEARCH_STEPS_MAX):
-        if last_range == (low, high):
-            if debug_prints:
-                print('last_range == (low, high)')
-            break
-        last_range = (low, high)
-
-        mid = (low+high)/2.0
-        if debug_prints:
-            print(f'{i}: low={low:.25f} mid={mid:.25f} high={high:.25f}')
-
-        mid_alpha = Mn_plus_distribution(n, mid)
-        if debug_prints:
-            print(f'Pr[M_{n} < {mid:.25f}] = {mid_alpha:.25f}')
-        if mid_alpha < alpha:
-            low = mid
-        else:
-            high = mid
-
-        if low >= high:
-            if debug_prints:
-                print('low >= high')
-            break
-    assert i < N_BINARY_SEARCH_STEPS_MAX-1, "Reached N_BINARY_SEARCH_STEPS_MAX => did not converge!"
-    result = mid
+    result = crossprob.find_threshold('mn-plus', n, alpha)
+    if debug_prints:
+        print(f'Pr[M_{n} < {result:.25f}] = {alpha}')
     alpha_bounds = Mn_plus_bounds(n, result)
     nocross_probability = 1.0 - crossprob.ecdf1_new_b(alpha_bounds)
     relative_error = absolute(alpha - nocross_probability)/alpha 
@@ -159,6 +133,9 @@ def precalc_timings_Mn_plus(alpha, max_ks2001_n, max_mns2016_n, num_reps):
     timings_mn2017 = [inf]*len(d.n_range)
     results_mn2017 = [None]*len(d.n_range)
 
+    timings_blocked = [inf]*len(d.n_range)
+    results_blocked = [None]*len(d.n_range)
+
     timings_new = [inf]*len(d.n_range)
     results_new = [None]*len(d.n_range)
 
@@ -183,6 +160,10 @@ def precalc_timings_Mn_plus(alpha, max_ks2001_n, max_mns2016_n, num_reps):
                 results_mn2017[i] = 1.0-crossprob.ecdf2(bounds, [1.0]*n, True)
             timings_mn2017[i] = min(timings_mn2017[i], t.elapsed)
 
+            with Timer('BLOCKED') as t:
+                results_blocked[i] = 1.0-crossprob.ecdf2_blocked(bounds, [1.0]*n)
+            timings_blocked[i] = min(timings_blocked[i], t.elapsed)
+
             with Timer('NEW') as t:
                 results_new[i] = 1.0-crossprob.ecdf1_new_b(bounds)
             timings_new[i] = min(timings_new[i], t.elapsed)
@@ -194,6 +175,7 @@ def precalc_timings_Mn_plus(alpha, max_ks2001_n, max_mns2016_n, num_reps):
                 ks2001 = (timings_ks2001, results_ks2001),
                 mns2016 = (timings_mns2016, results_mns2016),
                 mn2017 = (timings_mn2017, results_mn2017),
+                blocked = (timings_blocked, results_blocked),
                 new = (timings_new, results_new))
 
 
@@ -204,6 +186,9 @@ def precalc_timings_Mn_plus_largescale(threshold, n_range):
     timings_mn2017 = [inf]*len(n_range)
     results_mn2017 = [None]*len(n_range)
 
+    timings_blocked = [inf]*len(n_range)
+    results_blocked = [None]*len(n_range)
+
     timings_new = [inf]*len(n_range)
     results_new = [None]*len(n_range)
 
@@ -221,12 +206,17 @@ def precalc_timings_Mn_plus_largescale(threshold, n_range):
             results_mn2017[i] = 1.0-crossprob.ecdf2(bounds, [1.0]*n, True)
         timings_mn2017[i] = min(timings_mn2017[i], t.elapsed)
 
+        with Timer('BLOCKED') as t:
+            results_blocked[i] = 1.0-crossprob.ecdf2_blocked(bounds, [1.0]*n)
+        timings_blocked[i] = min(timings_blocked[i], t.elapsed)
+
 
         pickler.dump(f'Mn_plus_timings_largescale',
             n_range=n_range,
             threshold=threshold,
             cpu = CPU_BRAND_STRING,
             mn2017 = (timings_mn2017, results_mn2017),
+            blocked = (timings_blocked, results_blocked),
             new = (timings_new, results_new))
 
 
@@ -244,6 +234,9 @@ def plot_timings_Mn_plus(alpha, xlim=None, ylim=None, xticks=None, yticks=None,
 
         ax.plot(d.n_range, d.mn2017[0], label='MN (2017)')
 
+        if hasattr(d, 'blocked'):
+            ax.plot(d.n_range, d.blocked[0], label='MN (2017), blocked')
+
         ax.plot(d.n_range, d.new[0], label='New')
         ax.legend(loc='lower right')
         ax.grid(which='both')
@@ -288,6 +281,8 @@ def plot_timings_Mn_plus_largescale(xlim=None, ylim=None, xticks=None, yticks=No
         ax.plot([], [])
         ax.plot([], [])
         ax.plot(d.n_range, d.mn2017[0], label='MN (2017)')
+        if hasattr(d, 'blocked'):
+            ax.plot(d.n_range, d.blocked[0], label='MN (2017), blocked')
         ax.plot(d.n_range, d.new[0], label='New')
         ax.legend(loc='lower right')
         ax.grid(which='both')
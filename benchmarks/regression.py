@@ -0,0 +1,182 @@
+# Performance regression suite.
+#
+# Times the algorithms on the fixed corpus of boundaries of "bin/crossprob_bench --corpus" (constant-KS, Berk-Jones,
+# higher-criticism and random monotone bounds at several n) and reports every case. It flags
+#     - slowdowns: the samples are slower than the timing baseline of this machine by a one-sided Mann-Whitney U test
+#       with p < SLOWDOWN_P_VALUE, and the median is more than SLOWDOWN_RATIO times the baseline median.
+#       Both sides need at least MINIMUM_SAMPLES samples, fewer can't reach this p-value and are flagged as well.
+#     - accuracy drift: the computed probability differs from the checked-in value of benchmarks/regression_reference.json
+#       by more than ACCURACY_TOLERANCE.
+#     - inaccuracy: the computed probability differs from the reference probability, computed in quad precision by
+#       ecdf2_reference() (see src/ecdf2_reference.hh), by more than REFERENCE_TOLERANCE. The reference is taken
+#       from the current results if they were run with --reference, otherwise from regression_reference.json.
+# Exits with status 1 if anything was flagged.
+#
+# The probabilities are the same on all machines and are checked in. The timings are only comparable on the same
+# machine, so they are kept in a per-machine baseline, $CROSSPROB_REGRESSION_TIMINGS or else
+# $HOME/.crossprob_regression_timings.json. Without one, only the probabilities are compared.
+#
+# Usage (from the main dir, after running "make"):
+#     python3 benchmarks/regression.py                        Run the corpus and compare with the baselines.
+#     python3 benchmarks/regression.py --update-baseline      Run the corpus and save its timings as the baseline of this machine.
+#                                                             Do this before the changes to be measured, on an idle machine.
+#     python3 benchmarks/regression.py --update-reference     Run the corpus and save its probabilities to regression_reference.json,
+#                                                             after a change of the algorithms that is meant to change them.
+#     python3 benchmarks/regression.py --results <file>       Compare a saved "crossprob_bench --corpus --format=json" output.
+#     python3 benchmarks/regression.py --reference            Also compute the reference probabilities (slow, ~30 minutes).
+#                                                             Combine with --update-reference to store them.
+# Only the Python standard library is needed.
+
+import sys
+import os
+import json
+import math
+import argparse
+import subprocess
+
+REFERENCE_FILENAME = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'regression_reference.json')
+BENCH_BINARY = './bin/crossprob_bench'
+
+SLOWDOWN_P_VALUE = 0.001
+SLOWDOWN_RATIO = 1.1
+# With 30 samples on each side the smallest possible p-value is about 1e-11, so that slowdowns are detected
+# even with a few outliers. With 6 against 5 it is 0.004, which can never be below SLOWDOWN_P_VALUE.
+MINIMUM_SAMPLES = 30
+ACCURACY_TOLERANCE = 1e-9
+REFERENCE_TOLERANCE = 1e-9
+
+
+def default_timings_filename():
+    filename = os.environ.get('CROSSPROB_REGRESSION_TIMINGS')
+    if filename is not None:
+        return filename
+    return os.path.join(os.environ.get('HOME', '.'), '.crossprob_regression_timings.json')
+
+
+def run_corpus(max_n, min_time, reference):
+    output = subprocess.check_output([BENCH_BINARY, '--corpus', '--format=json', f'--max-n={max_n}', f'--min-time={min_time}', f'--min-samples={MINIMUM_SAMPLES}'] + (['--reference'] if reference else []))
+    return json.loads(output)
+
+
+def mann_whitney_p_value(baseline, current):
+    """One-sided p-value of the hypothesis that the current samples are not larger than the baseline samples.
+
+    Uses the normal approximation of the U statistic with a correction for ties."""
+    n0 = len(baseline)
+    n1 = len(current)
+    combined = sorted([(x, 0) for x in baseline] + [(x, 1) for x in current])
+    ranks = [0.0]*len(combined)
+    tie_correction = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while (j+1 < len(combined)) and (combined[j+1][0] == combined[i][0]):
+            j += 1
+        for k in range(i, j+1):
+            ranks[k] = 0.5*(i+j) + 1
+        t = j-i+1
+        tie_correction += t**3 - t
+        i = j+1
+    rank_sum = sum(r for (r, (_, group)) in zip(ranks, combined) if group == 1)
+    u = rank_sum - n1*(n1+1)/2
+    mean = n0*n1/2
+    variance = n0*n1/12 * ((n0+n1+1) - tie_correction/((n0+n1)*(n0+n1-1)))
+    if variance <= 0:
+        return 1.0
+    z = (u - mean - 0.5) / math.sqrt(variance)
+    return 0.5*math.erfc(z/math.sqrt(2))
+
+
+def median(samples):
+    s = sorted(samples)
+    return s[len(s)//2]
+
+
+def compare(references, timings, results):
+    """Compares the results with the checked-in probabilities and, unless timings is None, with the timing baseline."""
+    references_by_key = {(r['benchmark'], r['size']): r for r in references}
+    timings_by_key = {(r['benchmark'], r['size']): r for r in (timings or [])}
+    num_flagged = 0
+    print(f'{"benchmark":<28} {"n":>6} {"samples":>7} {"baseline_ms":>12} {"current_ms":>12} {"ratio":>7} {"p_value":>9} {"error":>8}  status')
+    for r in results:
+        key = (r['benchmark'], r['size'])
+        status = []
+        notes = []
+        baseline_ms = ratio = p_value = ''
+        if key in timings_by_key:
+            b = timings_by_key[key]
+            baseline_ms = f'{b["median_ns"]/1e6:.4f}'
+            ratio = median(r['samples_ns']) / median(b['samples_ns'])
+            if min(len(b['samples_ns']), len(r['samples_ns'])) < MINIMUM_SAMPLES:
+                status.append(f'TOO FEW SAMPLES ({len(b["samples_ns"])} and {len(r["samples_ns"])})')
+            else:
+                p_value = mann_whitney_p_value(b['samples_ns'], r['samples_ns'])
+                if (p_value < SLOWDOWN_P_VALUE) and (ratio > SLOWDOWN_RATIO):
+                    status.append('SLOWER')
+                p_value = f'{p_value:.2g}'
+            ratio = f'{ratio:.3f}'
+        elif timings is not None:
+            notes.append('no timing baseline')
+
+        reference = r.get('reference')
+        if key in references_by_key:
+            expected = references_by_key[key]
+            if not abs(r['result'] - expected['result']) <= ACCURACY_TOLERANCE:
+                status.append(f'ACCURACY DRIFT {expected["result"]!r} -> {r["result"]!r}')
+            if reference is None:
+                reference = expected.get('reference')
+        else:
+            notes.append('new')
+        error = '' if reference is None else f'{abs(r["result"] - reference):.1e}'
+        if (reference is not None) and not abs(r['result'] - reference) <= REFERENCE_TOLERANCE:
+            status.append(f'INACCURATE {r["result"]!r} instead of {reference!r}')
+
+        num_flagged += (len(status) > 0)
+        print(f'{r["benchmark"]:<28} {r["size"]:>6} {len(r["samples_ns"]):>7} {baseline_ms:>12} {r["median_ns"]/1e6:>12.4f} {ratio:>7} {p_value:>9} {error:>8}  {", ".join(status + notes) or "ok"}')
+    print(f'{num_flagged} of {len(results)} cases flagged.')
+    return num_flagged
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Performance regression suite of crossprob.')
+    parser.add_argument('--update-baseline', action='store_true', help='save the timings as the baseline of this machine')
+    parser.add_argument('--update-reference', action='store_true', help='save the probabilities as the checked-in reference values')
+    parser.add_argument('--results', help='compare the results in this file instead of running the corpus')
+    parser.add_argument('--baseline', default=default_timings_filename(), help='the timing baseline of this machine')
+    parser.add_argument('--references', default=REFERENCE_FILENAME, help='the checked-in probabilities')
+    parser.add_argument('--max-n', type=int, default=10000)
+    parser.add_argument('--min-time', type=float, default=0.3, help='minimum running time of each case in seconds')
+    parser.add_argument('--reference', action='store_true', help='also compute the reference probabilities in quad precision')
+    args = parser.parse_args()
+
+    if args.results is not None:
+        with open(args.results) as f:
+            results = json.load(f)
+    else:
+        results = run_corpus(args.max_n, args.min_time, args.reference)
+
+    if args.update_baseline:
+        with open(args.baseline, 'w') as f:
+            json.dump(results, f, indent=1)
+        print(f'Saved the timings of {len(results)} cases to {args.baseline}')
+    if args.update_reference:
+        references = [{key: r[key] for key in ['benchmark', 'size', 'result', 'reference'] if key in r} for r in results]
+        with open(args.references, 'w') as f:
+            json.dump(references, f, indent=1)
+        print(f'Saved the probabilities of {len(results)} cases to {args.references}')
+    if args.update_baseline or args.update_reference:
+        return 0
+
+    with open(args.references) as f:
+        references = json.load(f)
+    timings = None
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            timings = json.load(f)
+    else:
+        print(f'No timing baseline in {args.baseline}, only comparing the probabilities. Run with --update-baseline to create it.')
+    return 1 if compare(references, timings, results) > 0 else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,5 +1,56 @@
 from distutils.core import setup, Extension
 import os
+import glob
+import subprocess
+import sys
+
+# The wrapper python_extension/crossprob.cc and the module python_extension/crossprob.py are generated from
+# src/crossprob.i by SWIG (http://www.swig.org), which needs to be installed. They are not checked in, and are
+# regenerated whenever crossprob.i or one of the headers it wraps is newer.
+SWIG_INTERFACE = 'src/crossprob.i'
+SWIG_WRAPPER = 'python_extension/crossprob.cc'
+SWIG_MODULE = 'python_extension/crossprob.py'
+
+def generate_swig_wrapper():
+    inputs = [SWIG_INTERFACE] + glob.glob('src/*.hh')
+    if os.path.exists(SWIG_WRAPPER) and os.path.exists(SWIG_MODULE):
+        generated_time = min(os.path.getmtime(SWIG_WRAPPER), os.path.getmtime(SWIG_MODULE))
+        if all(os.path.getmtime(filename) <= generated_time for filename in inputs):
+            return
+    os.makedirs('python_extension', exist_ok=True)
+    try:
+        subprocess.check_call(['swig', '-c++', '-threads', '-python', '-o', SWIG_WRAPPER, SWIG_INTERFACE])
+    except OSError:
+        sys.exit('Building the python extension requires SWIG to generate ' + SWIG_WRAPPER + ' from ' + SWIG_INTERFACE + '.')
+
+generate_swig_wrapper()
+
+# The FFT backend, see src/fftwconvolver.hh. Set CROSSPROB_FFT in the environment to:
+#     fftw (default): FFTW3, in $FFTW_DIR/lib (default /usr/local/lib).
+#         Note that if you're running in Anaconda Python, it includes Intel's MKL implementation of FFT
+#         which is compatible with the FFTW3 API. In that case you don't actually need to link anything and the code will probably run slightly faster on Intel CPUs.
+#     mkl: Intel's MKL in $MKLROOT, through its FFTW3-compatible interface.
+#     builtin: only the builtin FFT, without any external library.
+FFT_BACKEND = os.environ.get('CROSSPROB_FFT', 'fftw')
+if FFT_BACKEND == 'builtin':
+    FFT_MACROS, FFT_COMPILE_ARGS, FFT_LINK_ARGS = [('CROSSPROB_NO_FFTW', None)], [], []
+elif FFT_BACKEND == 'mkl':
+    MKLROOT = os.environ.get('MKLROOT', '/opt/intel/mkl')
+    FFT_MACROS = [('CROSSPROB_FFT_MKL', None)]
+    FFT_COMPILE_ARGS = ['-I' + MKLROOT + '/include/fftw']
+    FFT_LINK_ARGS = ['-L' + MKLROOT + '/lib', '-Wl,-rpath,' + MKLROOT + '/lib', '-lmkl_intel_lp64', '-lmkl_sequential', '-lmkl_core']
+elif FFT_BACKEND == 'fftw':
+    FFTW_DIR = os.environ.get('FFTW_DIR', '/usr/local')
+    FFT_MACROS, FFT_COMPILE_ARGS, FFT_LINK_ARGS = [], ['-I' + FFTW_DIR + '/include'], ['-L' + FFTW_DIR + '/lib', '-lfftw3']
+else:
+    raise ValueError("Expecting CROSSPROB_FFT to be one of 'fftw', 'mkl', 'builtin'")
+
+# The reference engine (src/ecdf2_reference.hh) uses GCC's libquadmath. Set CROSSPROB_NO_QUADMATH=1 in the environment
+# to build without it, e.g. with clang.
+if os.environ.get('CROSSPROB_NO_QUADMATH'):
+    QUADMATH_MACROS, QUADMATH_LINK_ARGS = [('CROSSPROB_NO_QUADMATH', None)], []
+else:
+    QUADMATH_MACROS, QUADMATH_LINK_ARGS = [], ['-lquadmath']
 
 module1 = Extension(
     '_crossprob',
@@ -9,16 +60,30 @@ module1 = Extension(
         'src/poisson_pmf.cc',
         'src/fftwconvolver.cc',
         'src/ecdf1_mns2016.cc',
+        'src/polynomial_translated_monomials.cc',
         'src/ecdf1_new.cc',
         'src/ecdf2.cc',
-        'python_extension/crossprob.cc'
+        'src/boundary_families.cc',
+        'src/threshold_search.cc',
+        'src/checkpoints.cc',
+        'src/sorted_bounds.cc',
+        'src/ecdf2_blocked.cc',
+        'src/jump_size.cc',
+        'src/ecdf_auto.cc',
+        'src/profiling.cc',
+        'src/memory_usage.cc',
+        'src/array_interface.cc',
+        'src/batch.cc',
+        'src/ecdf2_reference.cc',
+        'src/error_estimate.cc',
+        'src/double_double.cc',
+        SWIG_WRAPPER
     ],
-    extra_compile_args = ['-Wall', '-std=c++11', '-ffast-math', '-march=native'],
+    extra_compile_args = ['-Wall', '-std=c++11', '-ffast-math', '-march=native'] + FFT_COMPILE_ARGS,
+    extra_link_args = FFT_LINK_ARGS + QUADMATH_LINK_ARGS,
 
-    # Path to FFTW3:
-    # Note that if you're running in Anaconda Python, it includes Intel's MKL implementation of FFT
-    # which is compatible with the FFTW3 API. In that case you don't actually need to link anything and the code will probably run slightly faster on Intel CPUs.
-    extra_link_args = ['-L/usr/local/lib/', '-lfftw3'],
+    # Set CROSSPROB_STATS=1 in the environment to compile in the profiling counters, see src/profiling.hh.
+    define_macros = ([('CROSSPROB_STATS', None)] if os.environ.get('CROSSPROB_STATS') else []) + FFT_MACROS + QUADMATH_MACROS,
 
     #undef_macros = ["NDEBUG"]
 )
@@ -43,6 +108,25 @@ Its parameters are:
     b, B: two lists of length n of the boundaries in Eq. (1) above.
     use_fft: If true algorithm the O(n^2 logn) algorithm [MNS2016] is used,
              otherwise the O(n^3) algorithm of [KS2001]
+    ecdf2_blocked(b, B)
+        Same as ecdf2(b, B, True) using an O(n^2) algorithm that processes about sqrt(w) steps of
+        the boundaries per large FFT convolution of the w active counts, similar to ecdf1_new_B().
+        Much faster than ecdf2() for two-sided bounds with a narrow window, such as Kolmogorov-Smirnov.
+    ecdf2_low_memory(b, B, use_fft)
+        Same as ecdf2(b, B, use_fft), with the FFT buffers sized to the largest window between the boundaries
+        rather than to n. For large n with narrow boundaries this needs a fraction of the memory.
+    ecdf2_reference(b, B)
+        Same as ecdf2(b, B, True) computed in quadruple precision, for measuring the round-off errors of the
+        other functions. About 100 times slower. ecdf2_reference_string(b, B) gives 30 significant digits.
+    ecdf2_dd(b, B)
+        Same as ecdf2(b, B, True) computed in double-double precision (about 32 digits), 5-10 times slower.
+        The result has the attributes noncrossing_probability and crossing_probability. The latter is
+        1 - noncrossing_probability computed before rounding, so it stays accurate far below 1e-16.
+    ecdf_with_error(algorithm, b, B)
+        The probability computed by one of 'auto', 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked',
+        with bounds on its round-off error. The result has the attributes probability, error_bound (a worst case
+        bound), error_estimate (a conservative estimate of the actual error, but not a bound), fft_convolutions,
+        naive_convolutions and negative_entries.
 
 Faster functions are available for the special case of a single boundary:
     ecdf1_new_b(b)
@@ -56,6 +140,112 @@ Faster functions are available for the special case of a single boundary:
         Implements the O(n^2) algorithm of [MNS2016]. b_i are implicitly assumed to be 0. 
         Generally slower and less numerically stable than ecdf1_new_B()
 
+Poisson processes:
+    poisson_noncrossing_probability(intensity, b, B, use_fft)
+        The probability that the arrival times T_1 <= T_2 <= ... of a homogeneous Poisson process on [0,1]
+        satisfy b_i <= T_i for i=1,...,len(b) and T_i <= B_i for i=1,...,len(B), where len(B) <= len(b).
+        In particular the process has at most len(b) arrivals.
+    poisson_noncrossing_probability_by_count(intensity, b, B, use_fft)
+        Same as above, split by the number of arrivals k=0,...,len(b).
+    poisson_noncrossing_probabilities(intensities, b, B, use_fft)
+    poisson_noncrossing_probabilities_by_count(intensities, b, B, use_fft)
+        Same as above for a list of intensities, computed in a single pass over the bounds.
+
+Non-uniform samples and non-homogeneous Poisson processes are supported through warps. A warp is a
+piecewise linear function given by two lists x, y of the same length. If x is empty, the values
+y are taken on a uniform grid over [0,1]:
+    ecdf2_warped(warp_x, warp_y, b, B, use_fft)
+        Same as ecdf2(b, B, use_fft) for a sample drawn from the distribution with CDF warp(t).
+    ecdf2_warped(warps_x, warps_y, b, B, use_fft)
+        Same as above for a list of warps, computed in a single pass over the bounds.
+    poisson_noncrossing_probabilities_warped(warps_x, warps_y, b, B, use_fft)
+    poisson_noncrossing_probabilities_by_count_warped(warps_x, warps_y, b, B, use_fft)
+        Same as poisson_noncrossing_probabilities() for Poisson processes whose cumulative intensities are the warps.
+
+The noncrossing probabilities of many related boundaries can be computed in one go:
+    ecdf2_all_sample_sizes(b, B, use_fft)
+        Returns a list whose m-th entry is ecdf2(b[:m], B[:m], use_fft), for m=0,...,n.
+    ecdf2_prefix_noncrossing_probabilities(b, B, use_fft, t)
+        Returns a list whose j-th entry is the probability that the empirical CDF does not cross
+        the boundaries in the interval [0, t[j]]. The list t must be sorted.
+
+Critical values of goodness-of-fit statistics can be computed using
+    find_threshold(family, n, alpha)
+        Returns the threshold x at which the boundaries of the given family have crossing probability alpha.
+        family is one of "ks-plus", "ks-minus", "ks", "mn-plus", "mn-minus", "mn".
+    boundary_family_crossing_probability(family, n, x)
+        The crossing probability of the boundaries of the given family at threshold x.
+    boundary_family_crossing_probabilities(family, n, x_list)
+        The crossing probabilities at each threshold in x_list, sharing the FFT plans and Poisson PMF tables.
+
+If unsure which of the above to use, the fastest one for the given boundaries is chosen automatically by
+    auto(b, B)
+        Computes the non-crossing probability. b or B may be an empty list for one-sided boundaries.
+    auto_algorithm(b, B)
+        The name of the algorithm used by auto(b, B), e.g. "ecdf2-blocked".
+    auto_algorithm_reason(b, B)
+        The same followed by the reason for choosing it.
+    ecdf_auto_with_tolerance(b, B, tolerance)
+        Same as auto(b, B), recomputed by ecdf2_dd() if the error_bound of ecdf_with_error() exceeds tolerance.
+        The result has the attributes probability, algorithm ("ecdf2-dd" if recomputed) and error_bound.
+    estimate_running_times(b, B)
+        The estimated running times of the applicable algorithms, fastest first.
+
+NumPy arrays are passed to the following functions without converting them element by element, which matters for large n:
+    ecdf2_array(b, B, use_fft=True), ecdf2_blocked_array(b, B), ecdf1_new_b_array(b), ecdf1_new_B_array(B)
+        Same as the functions above. b and B are converted to contiguous float64 arrays if they aren't already,
+        and their memory is then used in place, except that ecdf1_new_b_array() makes one copy of b reflected
+        into lower bounds, as ecdf1_new_b() does.
+    poisson_noncrossing_probability_by_count_array(intensity, b, B, use_fft=True)
+        Same as poisson_noncrossing_probability_by_count(), returning a NumPy array.
+
+All the functions release the GIL while computing, so calls from several Python threads run in parallel.
+The arrays passed to the *_array functions must not be modified by other threads during the call.
+
+Batches of boundaries are computed on a pool of native threads, which share the FFT plans:
+    Pool(num_threads=0, algorithm='auto')
+        num_threads=0 uses one thread per core. algorithm is one of 'auto', 'ecdf1-new', 'ecdf1-mns2016',
+        'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked'. Use close() or a with statement to stop the pool.
+    Pool.map(b, B)
+        The non-crossing probabilities as a NumPy array. b and B are 2-D arrays with one boundary per row,
+        or lists of 1-D arrays of any lengths. Either may be None for one-sided boundaries.
+    Pool.map_async(b, B)
+        Same as map(), returning a concurrent.futures.Future of the array.
+    Pool.submit(b, B)
+        A concurrent.futures.Future of the non-crossing probability of a single boundary.
+    ecdf_batch(algorithm, b_list, B_list, num_threads)
+        Same as Pool(num_threads, algorithm).map(b_list, B_list) for lists of lists, returning a list.
+
+When the module is built with CROSSPROB_STATS=1 in the environment, profiling counters are available:
+    get_profiling_stats()
+        A dict of the wall time and number of calls of the PMF generation, FFT and naive convolutions, rank-one
+        corrections and sorting since the last reset, and histograms of the convolution sizes.
+    reset_profiling_stats()
+    profiling_stats_enabled()
+
+The memory of the large buffers (FFT buffers, Poisson PMF tables and probability vectors) is tracked by
+    peak_allocated_bytes()
+        The largest number of bytes allocated at once since the last reset_peak_allocated_bytes().
+    reset_peak_allocated_bytes()
+
+The number of boundary steps that ecdf1_new_b(), ecdf1_new_B() and ecdf2_blocked() process per large FFT (the jump size)
+is tuned for the current machine:
+    calibrate_jump_size(filename, max_window_size)
+        Measures the convolution costs and saves a table of the best jump size per window size to filename.
+        The table in $CROSSPROB_CALIBRATION_FILE or $HOME/.crossprob_calibration is loaded automatically.
+    load_jump_size_calibration(filename)
+        Uses the table saved in filename.
+    set_jump_size(k)
+        Uses a fixed jump size k. set_jump_size(0) restores the automatic choice.
+
+The FFT library of the convolutions may be chosen at runtime:
+    available_fft_backends()
+        The backends of this build: 'fftw' (or 'mkl' when built with CROSSPROB_FFT=mkl in the environment) and
+        'builtin', a self-contained split-radix FFT. Building with CROSSPROB_FFT=builtin leaves only the latter.
+    set_fft_backend(name)
+        Used by the computations started afterwards. Defaults to $CROSSPROB_FFT_BACKEND, or else to the first one.
+    get_fft_backend()
+
 EXAMPLES
     For a sample X_1, X_2, X_3 with order statistics X_(1) <= X_(2) <= X(3), the probability
         Pr[X_(1)<=0.7 and 0.15<=X_(2)<=0.9 and 0.5<=X_(3)<=0.8]
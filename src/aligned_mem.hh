@@ -3,24 +3,43 @@
 
 #include <complex>
 #include <cstdlib>
+#include <memory>
 #include "mm_malloc.h"
+#include "memory_usage.hh"
 
 #define ALIGNMENT (32)
 
+// The size of each allocation is stored in the ALIGNMENT bytes before it, for add_allocated_bytes().
+inline void* allocate_aligned_bytes(long bytes)
+{
+    char* p = static_cast<char*>(_mm_malloc(bytes + ALIGNMENT, ALIGNMENT));
+    *reinterpret_cast<long*>(p) = bytes;
+    add_allocated_bytes(bytes);
+    return p + ALIGNMENT;
+}
+
 inline double* allocate_aligned_doubles(int n)
 {
-    return static_cast<double*>(_mm_malloc(n*sizeof(double), ALIGNMENT));
+    return static_cast<double*>(allocate_aligned_bytes(long(n)*sizeof(double)));
 }
 
 inline std::complex<double>* allocate_aligned_complexes(int n)
 {
-    return static_cast<std::complex<double>*>(_mm_malloc(n*sizeof(std::complex<double>), ALIGNMENT));
+    return static_cast<std::complex<double>*>(allocate_aligned_bytes(long(n)*sizeof(std::complex<double>)));
 }
 
 
 inline void free_aligned_mem(void* p)
 {
-    _mm_free(p);
+    char* start = static_cast<char*>(p) - ALIGNMENT;
+    add_allocated_bytes(-*reinterpret_cast<long*>(start));
+    _mm_free(start);
 }
 
+// Owns an array of allocate_aligned_doubles(), which is freed when it goes out of scope, including by an exception.
+struct AlignedMemDeleter {
+    void operator()(void* p) const { free_aligned_mem(p); }
+};
+typedef std::unique_ptr<double[], AlignedMemDeleter> AlignedDoubles;
+
 #endif
@@ -0,0 +1,79 @@
+#include <vector>
+#include <stdexcept>
+#include <sstream>
+#include <algorithm>
+
+#include "array_interface.hh"
+#include "common.hh"
+#include "poisson_pmf.hh"
+#include "computation_context.hh"
+#include "ecdf1_new.hh"
+#include "ecdf2.hh"
+#include "ecdf2_blocked.hh"
+
+using namespace std;
+
+double ecdf2_array(const double* b, int b_size, const double* B, int B_size, bool use_fft)
+{
+    int n = b_size;
+    check_boundary_array("b", n, b, b_size);
+    check_boundary_array("B", n, B, B_size);
+
+    ComputationContext ctx(n);
+    vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability(n, n, b, b_size, B, B_size, use_fft, ctx);
+    return poisson_nocross_probs[n] / poisson_pmf(n, n);
+}
+
+double ecdf2_blocked_array(const double* b, int b_size, const double* B, int B_size)
+{
+    int n = b_size;
+    check_boundary_array("b", n, b, b_size);
+    check_boundary_array("B", n, B, B_size);
+
+    ComputationContext ctx(n);
+    vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability_blocked(n, n, b, b_size, B, B_size, 0, ctx);
+    return poisson_nocross_probs[n] / poisson_pmf(n, n);
+}
+
+double ecdf1_new_b_array(const double* b, int b_size)
+{
+    int n = b_size;
+    check_boundary_array("b", n, b, b_size);
+
+    // ecdf1-new only sweeps lower bounds, so b is reflected into the lower bounds 1-b[n-1-i] as in ecdf1_new_b().
+    // This reflected copy is the only one made.
+    vector<double> symmetric_steps(n);
+    for (int i = 0; i < n; ++i) {
+        symmetric_steps[i] = 1.0 - b[n-1-i];
+    }
+    ComputationContext ctx(n);
+    return ecdf1_new_B(symmetric_steps, ctx);
+}
+
+double ecdf1_new_B_array(const double* B, int B_size)
+{
+    ComputationContext ctx(B_size);
+    return ecdf1_new_B(B, B_size, ctx);
+}
+
+void poisson_noncrossing_probability_by_count_array(double intensity, const double* b, int b_size, const double* B, int B_size, bool use_fft, double* out, int out_size)
+{
+    int n = b_size;
+    check_boundary_array("b", n, b, b_size);
+    check_boundary_array("B", B_size, B, B_size);
+    if (B_size > b_size) {
+        throw runtime_error("Expecting at most as many upper bounds B_i as lower bounds b_i.");
+    }
+    if (intensity < 0.0) {
+        throw runtime_error("Poisson process intensities must be non-negative.");
+    }
+    if (out_size != n+1) {
+        stringstream ss;
+        ss << "Expecting an output array of length " << n+1 << " but got one of length " << out_size << ".";
+        throw runtime_error(ss.str());
+    }
+
+    ComputationContext ctx(n);
+    vector<double> probs = poisson_process_noncrossing_probability(n, intensity, b, b_size, B, B_size, use_fft, ctx);
+    copy(probs.begin(), probs.end(), out);
+}
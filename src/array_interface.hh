@@ -0,0 +1,18 @@
+#ifndef __array_interface_hh__
+#define __array_interface_hh__
+
+// Entry points that take the bounds as arrays rather than std::vector, so that the Python extension can pass
+// the memory of NumPy arrays (or any other contiguous buffer of doubles) without converting them element by element.
+// The results of the vector valued functions are written to a caller supplied array.
+
+double ecdf2_array(const double* b, int b_size, const double* B, int B_size, bool use_fft);
+double ecdf2_blocked_array(const double* b, int b_size, const double* B, int B_size);
+
+// ecdf1_new_B_array() reads B in place. ecdf1_new_b_array() makes one copy of b, reflected into lower bounds.
+double ecdf1_new_b_array(const double* b, int b_size);
+double ecdf1_new_B_array(const double* B, int B_size);
+
+// Same as poisson_noncrossing_probability_by_count(intensity, b, B, use_fft). out must have b_size+1 entries.
+void poisson_noncrossing_probability_by_count_array(double intensity, const double* b, int b_size, const double* B, int B_size, bool use_fft, double* out, int out_size);
+
+#endif
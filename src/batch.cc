@@ -0,0 +1,163 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include "batch.hh"
+#include "common.hh"
+#include "computation_context.hh"
+#include "ecdf1_mns2016.hh"
+#include "ecdf1_new.hh"
+#include "ecdf2.hh"
+#include "ecdf2_blocked.hh"
+#include "ecdf_auto.hh"
+
+using namespace std;
+
+static void check_algorithm_name(const string& algorithm)
+{
+    const char* NAMES[] = {"auto", "ecdf1-new", "ecdf1-mns2016", "ecdf2-ks2001", "ecdf2-mn2017", "ecdf2-blocked"};
+    for (const char* name : NAMES) {
+        if (algorithm == name) {
+            return;
+        }
+    }
+    throw runtime_error("Unknown algorithm '" + algorithm + "'. Expecting one of: 'auto', 'ecdf1-new', 'ecdf1-mns2016', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked'.");
+}
+
+static bool all_equal(const vector<double>& v, double value)
+{
+    return find_if(v.begin(), v.end(), [value](double x) { return x != value; }) == v.end();
+}
+
+// Computes a single case with two complete boundaries of length n, reusing the thread's context while n stays the same.
+static double noncrossing_probability(const string& algorithm, const vector<double>& b, const vector<double>& B, unique_ptr<ComputationContext>& ctx)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+    if (!ctx || (ctx->get_n() != n)) {
+        ctx.reset(new ComputationContext(n));
+    }
+
+    string name = (algorithm == "auto") ? auto_algorithm(b, B) : algorithm;
+    if (name == "ecdf2-ks2001") {
+        return ecdf2(b, B, false, *ctx);
+    } else if (name == "ecdf2-mn2017") {
+        return ecdf2(b, B, true, *ctx);
+    } else if (name == "ecdf2-blocked") {
+        return ecdf2_blocked(b, B, *ctx);
+    }
+
+    // The one-sided algorithms, as in the ecdf1-* commands of the command line tool.
+    bool lower_is_trivial = all_equal(b, 0.0);
+    bool upper_is_trivial = all_equal(B, 1.0);
+    if (name == "ecdf1-new") {
+        if (lower_is_trivial) {
+            return ecdf1_new_B(B, *ctx);
+        } else if (upper_is_trivial) {
+            return ecdf1_new_b(b, *ctx);
+        }
+        return ecdf2_blocked(b, B, *ctx);
+    }
+    if (lower_is_trivial) {
+        return ecdf1_mns2016_B(B);
+    } else if (upper_is_trivial) {
+        return ecdf1_mns2016_b(b);
+    }
+    throw runtime_error("ecdf1-mns2016 expects one-sided boundaries, i.e. all b_i == 0 or all B_i == 1.");
+}
+
+// Calls compute(i, ctx) for i=0,...,count-1 on num_threads threads. Each thread takes the next case that no thread
+// has started and owns its context. The first error stops the remaining cases and is rethrown here.
+static void run_cases(int count, int num_threads, const function<void(int, unique_ptr<ComputationContext>&)>& compute)
+{
+    if (num_threads <= 0) {
+        num_threads = max(1u, thread::hardware_concurrency());
+    }
+    num_threads = min(num_threads, count);
+
+    atomic<int> next_case(0);
+    mutex error_mutex;
+    string error;
+    auto worker = [&]() {
+        unique_ptr<ComputationContext> ctx;
+        for (int i = next_case++; i < count; i = next_case++) {
+            try {
+                compute(i, ctx);
+            } catch (exception& e) {
+                lock_guard<mutex> lock(error_mutex);
+                if (error.empty()) {
+                    stringstream ss;
+                    ss << "Case " << i << ": " << e.what();
+                    error = ss.str();
+                }
+                next_case = count;
+            }
+        }
+    };
+
+    if (num_threads <= 1) {
+        worker();
+    } else {
+        vector<thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.push_back(thread(worker));
+        }
+        for (unsigned int t = 0; t < threads.size(); ++t) {
+            threads[t].join();
+        }
+    }
+    if (!error.empty()) {
+        throw runtime_error(error);
+    }
+}
+
+vector<double> ecdf_batch(const string& algorithm, const vector<vector<double> >& b, const vector<vector<double> >& B, int num_threads)
+{
+    check_algorithm_name(algorithm);
+    if (b.size() != B.size()) {
+        throw runtime_error("Expecting the same number of lower and upper boundaries.");
+    }
+
+    vector<double> results(b.size());
+    run_cases(b.size(), num_threads, [&](int i, unique_ptr<ComputationContext>& ctx) {
+        int n = max(b[i].size(), B[i].size());
+        if ((!b[i].empty() && ((int)b[i].size() != n)) || (!B[i].empty() && ((int)B[i].size() != n))) {
+            throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
+        }
+        results[i] = noncrossing_probability(algorithm, b[i].empty() ? vector<double>(n, 0.0) : b[i], B[i].empty() ? vector<double>(n, 1.0) : B[i], ctx);
+    });
+    return results;
+}
+
+void ecdf_batch_array(const string& algorithm, const double* b, int b_size, const double* B, int B_size, const vector<int>& offsets, int num_threads, double* out, int out_size)
+{
+    check_algorithm_name(algorithm);
+    if (offsets.empty() || (offsets.front() != 0) || (offsets.back() != b_size) || (b_size != B_size)) {
+        throw runtime_error("Expecting offsets that start at 0 and end at the common length of the boundary arrays b and B.");
+    }
+    for (unsigned int i = 1; i < offsets.size(); ++i) {
+        if (offsets[i] < offsets[i-1]) {
+            throw runtime_error("Expecting non-decreasing offsets.");
+        }
+    }
+    int count = offsets.size() - 1;
+    if (out_size != count) {
+        stringstream ss;
+        ss << "Expecting an output array of length " << count << " but got one of length " << out_size << ".";
+        throw runtime_error(ss.str());
+    }
+
+    run_cases(count, num_threads, [&](int i, unique_ptr<ComputationContext>& ctx) {
+        vector<double> case_b(b + offsets[i], b + offsets[i+1]);
+        vector<double> case_B(B + offsets[i], B + offsets[i+1]);
+        out[i] = noncrossing_probability(algorithm, case_b, case_B, ctx);
+    });
+}
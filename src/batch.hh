@@ -0,0 +1,21 @@
+#ifndef __batch_hh__
+#define __batch_hh__
+
+#include <vector>
+#include <string>
+
+// Computes the non-crossing probabilities of many boundaries on a pool of native threads, so that a batch of
+// p-values uses all the cores without one process per boundary. Each thread keeps a ComputationContext while
+// consecutive boundaries have the same n, and the FFT plans are shared by all the threads.
+//
+// algorithm is one of "auto", "ecdf1-new", "ecdf1-mns2016", "ecdf2-ks2001", "ecdf2-mn2017", "ecdf2-blocked".
+// num_threads <= 0 uses one thread per core. The results are the same as computing the boundaries one by one.
+
+// b[i] and B[i] are the boundaries of the i-th case. Either may be empty for one-sided boundaries.
+std::vector<double> ecdf_batch(const std::string& algorithm, const std::vector<std::vector<double> >& b, const std::vector<std::vector<double> >& B, int num_threads);
+
+// Same for boundaries stored back to back in two arrays: the i-th case is b[offsets[i]:offsets[i+1]] and
+// B[offsets[i]:offsets[i+1]], so out must have offsets.size()-1 entries.
+void ecdf_batch_array(const std::string& algorithm, const double* b, int b_size, const double* B, int B_size, const std::vector<int>& offsets, int num_threads, double* out, int out_size);
+
+#endif
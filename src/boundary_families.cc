@@ -0,0 +1,393 @@
+#include <cmath>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+
+#include "boundary_families.hh"
+
+using namespace std;
+
+// Stirling series remainder log(Gamma(x)) - ((x-0.5)*log(x) - x + 0.5*log(2*pi)), accurate for x >= 10.
+static double log_gamma_correction(double x)
+{
+    assert(x >= 10.0);
+    double x2 = 1.0 / (x*x);
+    return (1.0/12.0 - x2*(1.0/360.0 - x2*(1.0/1260.0 - x2*(1.0/1680.0 - x2*(1.0/1188.0 - x2*(691.0/360360.0 - x2/156.0)))))) / x;
+}
+
+// log(Gamma(q)) - log(Gamma(p+q)) for q >= 10, without the cancellation of subtracting two large numbers.
+static double log_gamma_ratio(double p, double q)
+{
+    return log_gamma_correction(q) - log_gamma_correction(p+q) + p - p*log(p+q) - (q-0.5)*log1p(p/q);
+}
+
+// Computes x^a (1-x)^b / Beta(a,b).
+// For large a and b the naive formula loses all accuracy to cancellation, so we center
+// the powers around the mode x0 = a/(a+b) and use Stirling's series for the Beta function.
+static double beta_power_terms(double a, double b, double x)
+{
+    double p = min(a, b);
+    double q = max(a, b);
+
+    if (p >= 10.0) {
+        // u = (x-x0)/x0 and v = (x0-x)/y0 where x0 = a/(a+b) and y0 = b/(a+b).
+        // Computing a-(a+b)*x with a single rounding avoids the cancellation of x0-x.
+        double d = fma(-(a+b), x, a);
+        double u = -d / a;
+        double v = d / b;
+        // log1p(u) == log(x/x0) and log1p(v) == log((1-x)/y0), but u,v may round to -1 when x is close to 0 or 1.
+        double log1p_u = (fabs(u) < 0.5) ? log1p(u) : log(x) - log(a/(a+b));
+        double log1p_v = (fabs(v) < 0.5) ? log1p(v) : log1p(-x) - log(b/(a+b));
+        double log_terms = a*(log1p_u - u) + b*(log1p_v - v);
+        double correction = log_gamma_correction(a+b) - log_gamma_correction(a) - log_gamma_correction(b);
+        return sqrt(a*b / (2*M_PI*(a+b))) * exp(log_terms + correction);
+    }
+
+    double log_beta;
+    if (q >= 10.0) {
+        log_beta = lgamma(p) + log_gamma_ratio(p, q);
+    } else {
+        log_beta = lgamma(a) + lgamma(b) - lgamma(a+b);
+    }
+    return exp(a*log(x) + b*log1p(-x) - log_beta);
+}
+
+// Continued fraction for the incomplete beta function, evaluated using the modified Lentz method.
+static double incomplete_beta_continued_fraction(double a, double b, double x)
+{
+    const int MAX_ITERATIONS = 100000;
+    const double EPSILON = numeric_limits<double>::epsilon();
+    const double TINY = numeric_limits<double>::min() / EPSILON;
+
+    double qab = a + b;
+    double qap = a + 1.0;
+    double qam = a - 1.0;
+    double c = 1.0;
+    double d = 1.0 - qab*x/qap;
+    if (fabs(d) < TINY) {
+        d = TINY;
+    }
+    d = 1.0 / d;
+    double h = d;
+    for (int m = 1; m <= MAX_ITERATIONS; ++m) {
+        int m2 = 2*m;
+        double aa = m*(b-m)*x / ((qam+m2)*(a+m2));
+        d = 1.0 + aa*d;
+        if (fabs(d) < TINY) {
+            d = TINY;
+        }
+        c = 1.0 + aa/c;
+        if (fabs(c) < TINY) {
+            c = TINY;
+        }
+        d = 1.0 / d;
+        h *= d*c;
+
+        aa = -(a+m)*(qab+m)*x / ((a+m2)*(qap+m2));
+        d = 1.0 + aa*d;
+        if (fabs(d) < TINY) {
+            d = TINY;
+        }
+        c = 1.0 + aa/c;
+        if (fabs(c) < TINY) {
+            c = TINY;
+        }
+        d = 1.0 / d;
+        double delta = d*c;
+        h *= delta;
+        if (fabs(delta - 1.0) <= EPSILON) {
+            return h;
+        }
+    }
+    throw runtime_error("incomplete_beta_continued_fraction() did not converge.");
+}
+
+// Computes both I_x(a,b) and 1-I_x(a,b). The smaller of the two is computed directly to avoid cancellation.
+static void incomplete_beta_tails(double a, double b, double x, double& lower, double& upper)
+{
+    if ((a <= 0.0) || (b <= 0.0)) {
+        throw runtime_error("The incomplete beta function expects a>0 and b>0.");
+    }
+    if (x <= 0.0) {
+        lower = 0.0;
+        upper = 1.0;
+    } else if (x >= 1.0) {
+        lower = 1.0;
+        upper = 0.0;
+    } else if (x < (a+1.0) / (a+b+2.0)) {
+        lower = beta_power_terms(a, b, x) * incomplete_beta_continued_fraction(a, b, x) / a;
+        upper = 1.0 - lower;
+    } else {
+        upper = beta_power_terms(a, b, x) * incomplete_beta_continued_fraction(b, a, 1.0-x) / b;
+        lower = 1.0 - upper;
+    }
+}
+
+double regularized_incomplete_beta(double a, double b, double x)
+{
+    double lower, upper;
+    incomplete_beta_tails(a, b, x, lower, upper);
+    return lower;
+}
+
+// Initial guess for the x such that I_x(a,b) = p, taken from Numerical Recipes (3rd edition, Section 6.14).
+static double inverse_incomplete_beta_initial_guess(double a, double b, double p)
+{
+    if ((a >= 1.0) && (b >= 1.0)) {
+        double pp = (p < 0.5) ? p : 1.0-p;
+        double t = sqrt(-2.0*log(pp));
+        double z = (2.30753 + t*0.27061) / (1.0 + t*(0.99229 + t*0.04481)) - t;
+        if (p < 0.5) {
+            z = -z;
+        }
+        double al = (z*z - 3.0) / 6.0;
+        double h = 2.0 / (1.0/(2.0*a-1.0) + 1.0/(2.0*b-1.0));
+        double w = (z*sqrt(al+h)/h) - (1.0/(2.0*b-1.0) - 1.0/(2.0*a-1.0))*(al + 5.0/6.0 - 2.0/(3.0*h));
+        return a / (a + b*exp(2.0*w));
+    } else {
+        double lna = log(a/(a+b));
+        double lnb = log(b/(a+b));
+        double t = exp(a*lna) / a;
+        double u = exp(b*lnb) / b;
+        double w = t + u;
+        if (p < t/w) {
+            return pow(a*w*p, 1.0/a);
+        } else {
+            return 1.0 - pow(b*w*(1.0-p), 1.0/b);
+        }
+    }
+}
+
+// Finds x such that I_x(a,b) = p (or 1-I_x(a,b) = p if upper_tail is true),
+// using Halley iterations safeguarded by bisection.
+static double solve_incomplete_beta(double a, double b, double p, bool upper_tail)
+{
+    if ((a <= 0.0) || (b <= 0.0)) {
+        throw runtime_error("The inverse incomplete beta function expects a>0 and b>0.");
+    }
+    if (p <= 0.0) {
+        return upper_tail ? 1.0 : 0.0;
+    }
+    if (p >= 1.0) {
+        return upper_tail ? 0.0 : 1.0;
+    }
+    // Closed form solutions for I_x(a,1) = x^a and I_x(1,b) = 1-(1-x)^b.
+    if (b == 1.0) {
+        return upper_tail ? exp(log1p(-p)/a) : exp(log(p)/a);
+    }
+    if (a == 1.0) {
+        return upper_tail ? -expm1(log(p)/b) : -expm1(log1p(-p)/b);
+    }
+
+    double x = upper_tail ? 1.0 - inverse_incomplete_beta_initial_guess(b, a, p) : inverse_incomplete_beta_initial_guess(a, b, p);
+
+    const int MAX_ITERATIONS = 1000;
+    const double EPSILON = 4*numeric_limits<double>::epsilon();
+    double a1 = a - 1.0;
+    double b1 = b - 1.0;
+    double low = 0.0;
+    double high = 1.0;
+    if (!((x > low) && (x < high))) {
+        x = 0.5;
+    }
+    for (int j = 0; j < MAX_ITERATIONS; ++j) {
+        double lower, upper;
+        incomplete_beta_tails(a, b, x, lower, upper);
+        double error = upper_tail ? p - upper : lower - p;
+        if (error == 0.0) {
+            return x;
+        }
+        if (error < 0.0) {
+            low = x;
+        } else {
+            high = x;
+        }
+
+        // The density of Beta(a,b) at x
+        double density = beta_power_terms(a, b, x) / (x*(1.0-x));
+        // Take a Halley step if the Newton step stays within the bracket, otherwise bisect.
+        // The comparison is done without dividing by the density, which may underflow far from the mode.
+        double x_next = 0.5*(low + high);
+        if (fabs(error) < density*(high - low)) {
+            double u = error / density;
+            double halley_step = u / (1.0 - 0.5*min(1.0, u*(a1/x - b1/(1.0-x))));
+            if (fabs(halley_step) <= EPSILON*x) {
+                return x;
+            }
+            if ((x - halley_step > low) && (x - halley_step < high)) {
+                x_next = x - halley_step;
+            }
+        }
+        if (fabs(x_next - x) <= EPSILON*x_next) {
+            return x_next;
+        }
+        x = x_next;
+    }
+    throw runtime_error("The inverse incomplete beta function did not converge.");
+}
+
+double inverse_regularized_incomplete_beta(double a, double b, double p)
+{
+    // 1-p is exact for p >= 0.5, and solving for the upper tail keeps the accuracy of p close to 1.
+    if (p <= 0.5) {
+        return solve_incomplete_beta(a, b, p, false);
+    } else {
+        return solve_incomplete_beta(a, b, 1.0-p, true);
+    }
+}
+
+double inverse_regularized_incomplete_beta_complement(double a, double b, double q)
+{
+    if (q <= 0.5) {
+        return solve_incomplete_beta(a, b, q, true);
+    } else {
+        return solve_incomplete_beta(a, b, 1.0-q, false);
+    }
+}
+
+static inline double clip01(double x)
+{
+    return min(1.0, max(0.0, x));
+}
+
+// Asymptotic threshold of the Kolmogorov-Smirnov statistic, based on the expansion
+//     Pr[sqrt(n) D_n^+ >= t] ~ exp(-2t^2 - 2t/(3 sqrt(n)))
+// due to Smirnov. Solves num_sides * exp(-2 n d^2 - 2d/3) = alpha for d.
+static double ks_asymptotic_threshold(int n, double alpha, int num_sides)
+{
+    double L = -log(alpha / num_sides);
+    return (-2.0/3.0 + sqrt(4.0/9.0 + 8.0*n*L)) / (4.0*n);
+}
+
+class KSPlusFamily : public BoundaryFamily {
+public:
+    void compute_bounds(int n, double x, vector<double>& b, vector<double>& B) const
+    {
+        b.resize(n);
+        for (int i = 0; i < n; ++i) {
+            b[i] = clip01(double(i+1)/n - x);
+        }
+        B.clear();
+    }
+    bool is_crossing_probability_increasing() const { return false; }
+    pair<double, double> bracket(int n, double alpha) const { return make_pair(0.0, 1.0); }
+    double asymptotic_threshold(int n, double alpha) const { return ks_asymptotic_threshold(n, alpha, 1); }
+};
+
+class KSMinusFamily : public BoundaryFamily {
+public:
+    void compute_bounds(int n, double x, vector<double>& b, vector<double>& B) const
+    {
+        b.clear();
+        B.resize(n);
+        for (int i = 0; i < n; ++i) {
+            B[i] = clip01(double(i)/n + x);
+        }
+    }
+    bool is_crossing_probability_increasing() const { return false; }
+    pair<double, double> bracket(int n, double alpha) const { return make_pair(0.0, 1.0); }
+    double asymptotic_threshold(int n, double alpha) const { return ks_asymptotic_threshold(n, alpha, 1); }
+};
+
+class KSFamily : public BoundaryFamily {
+public:
+    void compute_bounds(int n, double x, vector<double>& b, vector<double>& B) const
+    {
+        b.resize(n);
+        B.resize(n);
+        for (int i = 0; i < n; ++i) {
+            b[i] = clip01(double(i+1)/n - x);
+            B[i] = clip01(double(i)/n + x);
+        }
+    }
+    bool is_crossing_probability_increasing() const { return false; }
+    pair<double, double> bracket(int n, double alpha) const { return make_pair(0.0, 1.0); }
+    double asymptotic_threshold(int n, double alpha) const { return ks_asymptotic_threshold(n, alpha, 2); }
+};
+
+// The M_n thresholds are bracketed by Bonferroni's inequality: x <= Pr[M_n^+ < x] <= n*x.
+// The bracket is widened by a factor of 2 on each side, since the bounds are attained for n=1.
+static pair<double, double> mn_bracket(int n, double alpha, int num_sides)
+{
+    return make_pair(0.5*alpha / (num_sides*n), min(1.0, 2.0*alpha));
+}
+
+// The asymptotic threshold interpolates between these two extremes, the effective number of
+// independent tests (c*log(n)^1.5) was fit to exact thresholds for n = 10,...,10000.
+static double mn_asymptotic_threshold(int n, double alpha, int num_sides)
+{
+    double effective_num_tests = max(1.0, 2.2*pow(log(double(n)), 1.5));
+    return alpha / (num_sides * min(double(n), effective_num_tests));
+}
+
+class MnPlusFamily : public BoundaryFamily {
+public:
+    void compute_bounds(int n, double x, vector<double>& b, vector<double>& B) const
+    {
+        b.resize(n);
+        for (int i = 0; i < n; ++i) {
+            b[i] = inverse_regularized_incomplete_beta(i+1, n-i, x);
+        }
+        B.clear();
+    }
+    bool is_crossing_probability_increasing() const { return true; }
+    pair<double, double> bracket(int n, double alpha) const { return mn_bracket(n, alpha, 1); }
+    double asymptotic_threshold(int n, double alpha) const { return mn_asymptotic_threshold(n, alpha, 1); }
+};
+
+class MnMinusFamily : public BoundaryFamily {
+public:
+    void compute_bounds(int n, double x, vector<double>& b, vector<double>& B) const
+    {
+        b.clear();
+        B.resize(n);
+        for (int i = 0; i < n; ++i) {
+            B[i] = inverse_regularized_incomplete_beta_complement(i+1, n-i, x);
+        }
+    }
+    bool is_crossing_probability_increasing() const { return true; }
+    pair<double, double> bracket(int n, double alpha) const { return mn_bracket(n, alpha, 1); }
+    double asymptotic_threshold(int n, double alpha) const { return mn_asymptotic_threshold(n, alpha, 1); }
+};
+
+class MnFamily : public BoundaryFamily {
+public:
+    void compute_bounds(int n, double x, vector<double>& b, vector<double>& B) const
+    {
+        b.resize(n);
+        B.resize(n);
+        for (int i = 0; i < n; ++i) {
+            b[i] = inverse_regularized_incomplete_beta(i+1, n-i, x);
+            B[i] = inverse_regularized_incomplete_beta_complement(i+1, n-i, x);
+        }
+    }
+    bool is_crossing_probability_increasing() const { return true; }
+    pair<double, double> bracket(int n, double alpha) const { return mn_bracket(n, alpha, 2); }
+    double asymptotic_threshold(int n, double alpha) const { return mn_asymptotic_threshold(n, alpha, 2); }
+};
+
+const BoundaryFamily& get_boundary_family(const string& name)
+{
+    static const KSPlusFamily ks_plus;
+    static const KSMinusFamily ks_minus;
+    static const KSFamily ks;
+    static const MnPlusFamily mn_plus;
+    static const MnMinusFamily mn_minus;
+    static const MnFamily mn;
+
+    if (name == "ks-plus") {
+        return ks_plus;
+    } else if (name == "ks-minus") {
+        return ks_minus;
+    } else if (name == "ks") {
+        return ks;
+    } else if (name == "mn-plus") {
+        return mn_plus;
+    } else if (name == "mn-minus") {
+        return mn_minus;
+    } else if (name == "mn") {
+        return mn;
+    }
+    throw runtime_error("Unknown boundary family '" + name + "'. Expecting one of: 'ks-plus', 'ks-minus', 'ks', 'mn-plus', 'mn-minus', 'mn'.");
+}
@@ -0,0 +1,51 @@
+#ifndef __boundary_families_hh__
+#define __boundary_families_hh__
+
+#include <vector>
+#include <string>
+#include <utility>
+
+// The regularized incomplete beta function I_x(a,b), i.e. the CDF at x of a Beta(a,b) random variable.
+double regularized_incomplete_beta(double a, double b, double x);
+
+// The inverse of I_x(a,b) with respect to x. Returns x such that I_x(a,b) = p.
+double inverse_regularized_incomplete_beta(double a, double b, double p);
+
+// Returns x such that 1-I_x(a,b) = q. More accurate than inverse_regularized_incomplete_beta(a, b, 1-q) for small q.
+double inverse_regularized_incomplete_beta_complement(double a, double b, double q);
+
+// A family of boundaries b(x), B(x) indexed by a scalar threshold x. Typically this is the acceptance region
+// of a goodness-of-fit statistic, so that the crossing probability of the boundaries at x is the probability
+// that the statistic exceeds the threshold x (or falls below it).
+//
+// One-sided families leave either b or B empty.
+class BoundaryFamily {
+public:
+    virtual ~BoundaryFamily() {}
+
+    // Fills b and B with the boundaries that correspond to sample size n and threshold x.
+    virtual void compute_bounds(int n, double x, std::vector<double>& b, std::vector<double>& B) const = 0;
+
+    // True if the crossing probability is an increasing function of x, false if it is decreasing.
+    virtual bool is_crossing_probability_increasing() const = 0;
+
+    // An interval of thresholds that contains the threshold whose crossing probability is alpha.
+    virtual std::pair<double, double> bracket(int n, double alpha) const = 0;
+
+    // An asymptotic approximation of the threshold whose crossing probability is alpha.
+    // Used as the starting point of the threshold search.
+    virtual double asymptotic_threshold(int n, double alpha) const = 0;
+};
+
+// Returns one of the built-in boundary families:
+//     "ks-plus":  one-sided Kolmogorov-Smirnov D_n^+ = max_i (i/n - X_(i)).
+//     "ks-minus": one-sided Kolmogorov-Smirnov D_n^- = max_i (X_(i) - (i-1)/n).
+//     "ks":       two-sided Kolmogorov-Smirnov D_n = max(D_n^+, D_n^-).
+//     "mn-plus":  one-sided exact Berk-Jones M_n^+ = min_i Pr[U_(i) < X_(i)]. [MNS2016]
+//     "mn-minus": one-sided exact Berk-Jones M_n^- = min_i Pr[U_(i) > X_(i)]. [MNS2016]
+//     "mn":       two-sided exact Berk-Jones M_n = min(M_n^+, M_n^-). [MNS2016]
+// where U_(i) is the i-th order statistic of n uniform samples. For the KS families the crossing probability
+// at x is Pr[D >= x] and for the M_n families it is Pr[M < x].
+const BoundaryFamily& get_boundary_family(const std::string& name);
+
+#endif
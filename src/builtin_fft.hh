@@ -0,0 +1,130 @@
+#ifndef __builtin_fft_hh__
+#define __builtin_fft_hh__
+
+#include <vector>
+#include <complex>
+#include <cmath>
+#include <cassert>
+
+// e^{-2 pi i j/n} in the floating point type T. Specialize this for types without std::cos() and std::sin(),
+// see ecdf2_reference.cc.
+template <typename T>
+struct FFTUnitRoot {
+    static std::complex<T> get(int j, int n)
+    {
+        const T PI = 3.14159265358979323846L;
+        return std::polar(T(1), -2*PI*j/n);
+    }
+};
+
+// A self-contained real FFT for the "builtin" backend of FFTWConvolver, used when FFTW isn't available.
+// A real transform of size N is done by a complex transform of size N/2 on the interleaved even and odd samples,
+// which is computed by the recursive split-radix algorithm. N must be a power of 2, at least 4.
+// The conventions are those of FFTW's r2c and c2r plans: the forward transform gives the N/2+1 non-negative frequencies
+// and the backward transform is unnormalized, i.e. backward(forward(x)) = N*x.
+// T is the floating point type, e.g. __float128 in the reference engine of ecdf2_reference.hh.
+template <typename T>
+class BasicRealFFT {
+public:
+    typedef std::complex<T> Complex;
+
+    BasicRealFFT(int size) : size(size), half(size/2), twiddles(size/2), real_twiddles(size/2), work(size/2), transformed(size/2)
+    {
+        assert((size >= 4) && ((size & (size-1)) == 0));
+        for (int j = 0; j < half; ++j) {
+            twiddles[j] = FFTUnitRoot<T>::get(j, half);
+            real_twiddles[j] = FFTUnitRoot<T>::get(j, size);
+        }
+    }
+
+    int get_size() const { return size; }
+
+    // out[k] = sum_j in[j] e^{-2 pi i jk/N} for k=0,...,N/2.
+    void forward(const T* in, Complex* out)
+    {
+        for (int m = 0; m < half; ++m) {
+            work[m] = Complex(in[2*m], in[2*m+1]);
+        }
+        split_radix(work.data(), 1, transformed.data(), half);
+        // Z[k] = E[k] + i O[k], where E and O are the transforms of the even and odd samples.
+        const Complex I(T(0), T(1));
+        for (int k = 0; k <= half/2; ++k) {
+            Complex z = transformed[k];
+            Complex z_mirror = std::conj(transformed[(half-k) % half]);
+            Complex even = T(0.5)*(z + z_mirror);
+            Complex odd = T(-0.5)*I*(z - z_mirror);
+            out[k] = even + real_twiddles[k]*odd;
+            if (k > 0) {
+                // X[N/2-k] = conj(E[k]) - conj(W^k O[k]).
+                out[half-k] = std::conj(even - real_twiddles[k]*odd);
+            }
+        }
+        out[half] = Complex(transformed[0].real() - transformed[0].imag(), T(0));
+    }
+
+    // out[j] = sum_k in[k] e^{2 pi i jk/N} over all N frequencies, with in[N-k] = conj(in[k]), for j=0,...,N-1.
+    void backward(const Complex* in, T* out)
+    {
+        // The inverse of forward(): 2E[k] = X[k] + conj(X[N/2-k]) and 2O[k] = (X[k] - conj(X[N/2-k])) / W^k.
+        // The complex transform is inverted by conjugating its input and output.
+        const Complex I(T(0), T(1));
+        for (int k = 0; k < half; ++k) {
+            Complex x = in[k];
+            Complex x_mirror = std::conj(in[half-k]);
+            Complex even = x + x_mirror;
+            Complex odd = (x - x_mirror)*std::conj(real_twiddles[k]);
+            work[k] = std::conj(even + I*odd);
+        }
+        split_radix(work.data(), 1, transformed.data(), half);
+        for (int m = 0; m < half; ++m) {
+            out[2*m] = transformed[m].real();
+            out[2*m+1] = -transformed[m].imag();
+        }
+    }
+
+private:
+    int size;
+    int half;
+    std::vector<Complex> twiddles;
+    std::vector<Complex> real_twiddles;
+    std::vector<Complex> work;
+    std::vector<Complex> transformed;
+
+    // out[k] = sum_j in[j*stride] e^{-2 pi i jk/n} for k=0,...,n-1. Splits the input into the even samples and the
+    // samples at 4j+1 and 4j+3, which are combined using the twiddle factors W^k and W^3k.
+    void split_radix(const Complex* in, int stride, Complex* out, int n)
+    {
+        if (n == 1) {
+            out[0] = in[0];
+            return;
+        }
+        if (n == 2) {
+            out[0] = in[0] + in[stride];
+            out[1] = in[0] - in[stride];
+            return;
+        }
+        int quarter = n/4;
+        split_radix(in, 2*stride, out, n/2);
+        split_radix(in + stride, 4*stride, out + n/2, quarter);
+        split_radix(in + 3*stride, 4*stride, out + 3*quarter, quarter);
+
+        int twiddle_step = half/n;
+        for (int k = 0; k < quarter; ++k) {
+            Complex z1 = twiddles[k*twiddle_step]*out[n/2 + k];
+            Complex z3 = twiddles[3*k*twiddle_step]*out[3*quarter + k];
+            Complex sum = z1 + z3;
+            // -i*(z1 - z3)
+            Complex rotated_difference(z1.imag() - z3.imag(), z3.real() - z1.real());
+            Complex u0 = out[k];
+            Complex u1 = out[k + quarter];
+            out[k] = u0 + sum;
+            out[k + n/2] = u0 - sum;
+            out[k + quarter] = u1 + rotated_difference;
+            out[k + 3*quarter] = u1 - rotated_difference;
+        }
+    }
+};
+
+typedef BasicRealFFT<double> BuiltinRealFFT;
+
+#endif
@@ -0,0 +1,63 @@
+#include <stdexcept>
+#include <algorithm>
+
+#include "checkpoints.hh"
+
+using namespace std;
+
+NoncrossingCheckpoints::NoncrossingCheckpoints(int interval) :
+    interval(interval), resumed_step(0)
+{
+    if (interval <= 0) {
+        throw runtime_error("NoncrossingCheckpoints expects a positive checkpoint interval.");
+    }
+}
+
+void NoncrossingCheckpoints::clear()
+{
+    resumed_step = 0;
+    parameters.clear();
+    locations.clear();
+    tags.clear();
+    checkpoints.clear();
+}
+
+const Checkpoint* NoncrossingCheckpoints::resume(const vector<double>& new_parameters, const vector<double>& new_locations, const vector<int>& new_tags)
+{
+    int common_prefix = 0;
+    if (new_parameters == parameters) {
+        int max_prefix = min(locations.size(), new_locations.size());
+        while ((common_prefix < max_prefix) && (locations[common_prefix] == new_locations[common_prefix]) && (tags[common_prefix] == new_tags[common_prefix])) {
+            ++common_prefix;
+        }
+    }
+    while (!checkpoints.empty() && (checkpoints.back().step > common_prefix)) {
+        checkpoints.pop_back();
+    }
+
+    parameters = new_parameters;
+    locations = new_locations;
+    tags = new_tags;
+
+    if (checkpoints.empty()) {
+        resumed_step = 0;
+        return NULL;
+    }
+    resumed_step = checkpoints.back().step;
+    return &checkpoints.back();
+}
+
+void NoncrossingCheckpoints::save_if_due(int step, double location, int b_step_count, int B_step_count, const vector<double>& state)
+{
+    int last_step = checkpoints.empty() ? 0 : checkpoints.back().step;
+    if (step < last_step + interval) {
+        return;
+    }
+    Checkpoint checkpoint;
+    checkpoint.step = step;
+    checkpoint.location = location;
+    checkpoint.b_step_count = b_step_count;
+    checkpoint.B_step_count = B_step_count;
+    checkpoint.state = state;
+    checkpoints.push_back(checkpoint);
+}
@@ -0,0 +1,50 @@
+#ifndef __checkpoints_hh__
+#define __checkpoints_hh__
+
+#include <vector>
+
+// The state of a Poisson process recursion just before processing a given step.
+struct Checkpoint {
+    int step;
+    double location;
+    int b_step_count;
+    int B_step_count;
+    std::vector<double> state;
+};
+
+// Snapshots of the state of poisson_process_noncrossing_probability() or poisson_B_noncrossing_probability_n2().
+//
+// When successive calls are made with boundaries that share a common prefix (e.g. during a threshold search
+// where only the tail of the boundary changes) the next call resumes from the last snapshot within the
+// common prefix, so only the suffix is recomputed. The results are identical to those of a full computation.
+//
+// A snapshot is taken at most once every interval steps, each one holding a vector of length n+1.
+class NoncrossingCheckpoints {
+public:
+    NoncrossingCheckpoints(int interval);
+    int get_interval() const { return interval; }
+
+    // The step from which the last computation was resumed, or 0 if it was computed from scratch.
+    int get_resumed_step() const { return resumed_step; }
+
+    void clear();
+
+    // Called by the algorithms at the beginning of a computation.
+    // The steps are described by their locations and tags, parameters holds everything else that affects the state.
+    // Returns the latest snapshot whose steps [0, step) are the same as in the previous computation (or NULL).
+    // Later snapshots are discarded.
+    const Checkpoint* resume(const std::vector<double>& parameters, const std::vector<double>& locations, const std::vector<int>& tags);
+
+    // Called by the algorithms before processing each step. Copies the state if a snapshot is due.
+    void save_if_due(int step, double location, int b_step_count, int B_step_count, const std::vector<double>& state);
+
+private:
+    int interval;
+    int resumed_step;
+    std::vector<double> parameters;
+    std::vector<double> locations;
+    std::vector<int> tags;
+    std::vector<Checkpoint> checkpoints;
+};
+
+#endif
@@ -1,15 +1,17 @@
 #include "common.hh"
+#include "profiling.hh"
 
 #include <stdexcept>
 #include <sstream>
+#include <limits>
 
 using namespace std;
 
 
-static bool is_monotone_increasing(const vector<double>& v)
+static bool is_monotone_increasing(const double* v, int size)
 {
     double prev = -numeric_limits<double>::infinity();
-    for (int i = 0; i < (int)v.size(); ++i) {
+    for (int i = 0; i < size; ++i) {
         if (v[i] < prev) {
             return false;
         }
@@ -20,19 +22,24 @@ static bool is_monotone_increasing(const vector<double>& v)
 
 void check_boundary_vector(string name, int n, const vector<double>& v)
 {
-    if ((int)v.size() != n) {
+    check_boundary_array(name, n, v.data(), v.size());
+}
+
+void check_boundary_array(string name, int n, const double* v, int size)
+{
+    if (size != n) {
         stringstream ss;
-        ss << "Expecting " << n << " input bounds " << name << "_1,...," << name << "_" << n << " but got input of length " << v.size() << ".";
+        ss << "Expecting " << n << " input bounds " << name << "_1,...," << name << "_" << n << " but got input of length " << size << ".";
         throw runtime_error(ss.str());
     }
 
-    if (!is_monotone_increasing(v)) {
+    if (!is_monotone_increasing(v, size)) {
         stringstream ss;
         ss << name << "_1,...," << name << "_" << n << " must be monotone non-decreasing.";
         throw runtime_error(ss.str());
     }
 
-    if ((v.size() > 0) && ((v.front() < 0.0) || (v.back() > 1.0))) {
+    if ((size > 0) && ((v[0] < 0.0) || (v[size-1] > 1.0))) {
         stringstream ss;
         ss << name << "_1,...," << name << "_" << n << " must be in the interval [0,1].";
         throw runtime_error(ss.str());
@@ -41,6 +48,8 @@ void check_boundary_vector(string name, int n, const vector<double>& v)
 
 void convolve_same_size(int size, const double* src0, const double* src1, double* dest)
 {
+    PROFILE_PHASE(PHASE_NAIVE_CONVOLUTION);
+    PROFILE_CONVOLUTION(false, size, size);
     for (int j = 0; j < size; ++j) {
         double convolution_at_j = 0.0;
         for (int k = 0; k <= j; ++k) {
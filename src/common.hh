@@ -3,8 +3,11 @@
 
 #include <vector>
 #include <string>
+#include <iterator>
+#include <ostream>
 
 void check_boundary_vector(std::string name, int n, const std::vector<double>& v);
+void check_boundary_array(std::string name, int n, const double* v, int size);
 
 void convolve_same_size(int size, const double* src0, const double* src1, double* dest);
 
@@ -0,0 +1,41 @@
+#ifndef __computation_context_hh__
+#define __computation_context_hh__
+
+#include "fftwconvolver.hh"
+#include "poisson_pmf.hh"
+#include "sorted_bounds.hh"
+
+// Holds the FFT plans, Poisson PMF tables and sorted bound buffers used by the O(n^2) and O(n^2 log n) algorithms.
+// Computing many crossing probabilities with the same n (e.g. when searching for a threshold)
+// can reuse a single context instead of rebuilding these for every call.
+class ComputationContext {
+public:
+    ComputationContext(int n) : n(n), max_window_size(n+1), fftconvolver(n+1), pmfgen(n+1), error_tracker(NULL) {}
+    // A smaller context for ecdf2_low_memory(), whose FFT buffers and PMF tables only fit active windows of
+    // up to max_window_size counts rather than n+1.
+    ComputationContext(int n, int max_window_size) :
+        n(n), max_window_size(max_window_size), fftconvolver(max_window_size), pmfgen(max_window_size), error_tracker(NULL) {}
+    int get_n() const { return n; }
+    int get_max_window_size() const { return max_window_size; }
+    FFTWConvolver& get_convolver() { return fftconvolver; }
+    PoissonPMFGenerator& get_pmfgen() { return pmfgen; }
+    SortedBounds& get_sorted_bounds() { return sorted_bounds; }
+    // Accumulates the round-off errors of the computations with this context in tracker, see error_estimate.hh.
+    // NULL, the default, turns the tracking off.
+    void set_error_tracker(ErrorTracker* tracker)
+    {
+        error_tracker = tracker;
+        fftconvolver.set_error_tracker(tracker);
+        pmfgen.set_error_tracker(tracker);
+    }
+    ErrorTracker* get_error_tracker() { return error_tracker; }
+private:
+    int n;
+    int max_window_size;
+    FFTWConvolver fftconvolver;
+    PoissonPMFGenerator pmfgen;
+    SortedBounds sorted_bounds;
+    ErrorTracker* error_tracker;
+};
+
+#endif
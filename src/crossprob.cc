@@ -1,6 +1,8 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <vector>
+#include <map>
 #include <stdexcept>
 #include <cassert>
 #include <algorithm>
@@ -12,13 +14,41 @@
 #include "ecdf1_mns2016.hh"
 #include "ecdf1_new.hh"
 #include "ecdf2.hh"
+#include "ecdf2_blocked.hh"
+#include "ecdf_auto.hh"
+#include "profiling.hh"
+#include "memory_usage.hh"
+#include "threshold_search.hh"
+#include "jump_size.hh"
+#include "batch.hh"
+#include "fftwconvolver.hh"
+#include "ecdf2_reference.hh"
+#include "double_double.hh"
+#include "error_estimate.hh"
 
 using namespace std;
 
+static bool verbose = false;
+static bool print_stats = false;
+static bool low_memory = false;
+static bool print_memory = false;
+static bool with_error = false;
+static int num_threads = 0;
+static double tolerance = 0.0;
+
 static void print_usage()
 {
     cout << "SYNOPSIS\n";
     cout << "    crossprob <algorithm> <one-or-two-sided-boundaries-filename>\n";
+    cout << "    crossprob poisson <intensity>[,<intensity>,...] <boundaries-filename>\n";
+    cout << "    crossprob ecdf2-warped <warps-filename> <one-or-two-sided-boundaries-filename>\n";
+    cout << "    crossprob threshold <boundary-family> <n> <alpha>\n";
+    cout << "    crossprob crossing <boundary-family> <n> <x>[,<x>,...]\n";
+    cout << "    crossprob calibrate [<max-window-size>]\n";
+    cout << "    crossprob batch <algorithm> <boundaries-filename> [<boundaries-filename> ...]\n";
+    cout << "\n";
+    cout << "    The options --jump-size=<k>, --threads=<k>, --fft=<backend>, --low-memory, --verbose, --tolerance=<t>, --stats, --memory and --with-error\n";
+    cout << "    may be given before any of the above commands.\n";
     cout << "\n";
     cout << "DESCRIPTION\n";
     cout << "    Let X_1, ..., X_n be a set of points sampled uniformly from the interval [0,1]\n";
@@ -38,8 +68,18 @@ static void print_usage()
     cout << "    <algorithm>\n";
     cout << "        ecdf2-ks2001: an O(n^3) algorithm for two-sided boundaries. [KS2001]\n";
     cout << "        ecdf2-mn2017: an O(n^2 log n) method for two-sided boundaries. [MN2017]\n";
+    cout << "        ecdf2-blocked: an O(n^2) variant of ecdf2-mn2017 that does about sqrt(w) steps per large FFT of the w active counts, as in [NEW].\n";
     cout << "        ecdf1-mns2016: an O(n^2) method for one-sided boundaries. [MNS2016]\n";
     cout << "        ecdf1-new: New O(n^2) method, typically faster than ecdf1-mns2016. [NEW]\n";
+    cout << "            Given two-sided boundaries it runs ecdf2-blocked.\n";
+    cout << "        auto: runs the algorithm with the lowest estimated running time for the given boundaries.\n";
+    cout << "            The estimate depends on n and on the widths of the window between the boundaries.\n";
+    cout << "            With --tolerance=<t>, it is recomputed by ecdf2-dd if its round-off error bound exceeds t.\n";
+    cout << "        ecdf2-reference: ecdf2-mn2017 in quadruple precision, printed with 30 significant digits.\n";
+    cout << "            For measuring the round-off errors of the other algorithms. About 100 times slower than ecdf2-mn2017.\n";
+    cout << "        ecdf2-dd: ecdf2-mn2017 in double-double precision (about 32 digits). Prints the non-crossing probability and\n";
+    cout << "            then the crossing probability, which is accurate even when it is far below 1e-16. 5-10 times slower\n";
+    cout << "            than ecdf2-mn2017, and doesn't need libquadmath.\n";
     cout << "\n";            
     cout << "    <one-or-two-sided-boundaries-filename>\n";
     cout << "        This text file contains the two lines of comma-separater numbers:\n";
@@ -53,6 +93,75 @@ static void print_usage()
     cout << "        For the one-sided ecdf1-* algorithms one of the input lines must\n";
     cout << "        have n elements and the other line must be empty.\n";
     cout << "\n";
+    cout << "    poisson <intensity>[,<intensity>,...] <boundaries-filename>\n";
+    cout << "        Computes the non-crossing probability of a homogeneous Poisson process on [0,1] with the given intensity,\n";
+    cout << "        i.e. the probability that its arrival times T_1 <= T_2 <= ... satisfy b_i <= T_i <= B_i.\n";
+    cout << "        The process has at most n arrivals where n is the number of b_i. If the first line of the file is empty,\n";
+    cout << "        b_i is implicitly assumed to be 0. If the second line is empty, the arrival times are not bounded from above.\n";
+    cout << "        Several comma-separated intensities may be given, these are computed in a single pass.\n";
+    cout << "\n";
+    cout << "    ecdf2-warped <warps-filename> <one-or-two-sided-boundaries-filename>\n";
+    cout << "        Same as ecdf2-mn2017, for samples from a non-uniform distribution on [0,1].\n";
+    cout << "        The warps file contains one or more CDFs, each one given by two lines of comma-separated numbers:\n";
+    cout << "            x_0, x_1, ..., x_K\n";
+    cout << "            F(x_0), F(x_1), ..., F(x_K)\n";
+    cout << "        F is linearly interpolated between these points. If the first line is empty, x_k = k/K.\n";
+    cout << "        Prints the non-crossing probability under each CDF. These are computed in a single pass.\n";
+    cout << "\n";
+    cout << "    threshold <boundary-family> <n> <alpha>\n";
+    cout << "        Finds the threshold x at which the boundaries of a goodness-of-fit statistic\n";
+    cout << "        have crossing probability alpha (i.e. the critical value of a level alpha test).\n";
+    cout << "        <boundary-family> is one of:\n";
+    cout << "            ks-plus, ks-minus, ks: Kolmogorov-Smirnov D_n^+, D_n^- and D_n. Crossing probability is Pr[D >= x].\n";
+    cout << "            mn-plus, mn-minus, mn: exact Berk-Jones M_n^+, M_n^- and M_n. Crossing probability is Pr[M < x]. [MNS2016]\n";
+    cout << "\n";
+    cout << "    crossing <boundary-family> <n> <x>[,<x>,...]\n";
+    cout << "        Prints the crossing probability of the boundaries of <boundary-family> (see above) at each threshold x.\n";
+    cout << "        The thresholds share the FFT plans and Poisson PMF tables.\n";
+    cout << "\n";
+    cout << "    calibrate [<max-window-size>]\n";
+    cout << "        Measures the speed of the FFT and naive convolutions on this machine and picks the best jump size\n";
+    cout << "        (the number of boundary steps per large convolution) of ecdf1-new for each window size up to\n";
+    cout << "        <max-window-size> (default 100000). The table is saved to $CROSSPROB_CALIBRATION_FILE, or else to\n";
+    cout << "        $HOME/.crossprob_calibration, and is used by all later runs.\n";
+    cout << "\n";
+    cout << "    --jump-size=<k>\n";
+    cout << "        Use a fixed jump size k in ecdf1-new and ecdf2-blocked instead of the calibrated one.\n";
+    cout << "\n";
+    cout << "    --threads=<k>\n";
+    cout << "        Use k threads in the batch command instead of one per core.\n";
+    cout << "\n";
+    cout << "    --fft=<backend>\n";
+    cout << "        The FFT library of the convolutions: 'fftw' (or 'mkl' when built with \"make FFT=mkl\") or 'builtin',\n";
+    cout << "        a self-contained split-radix FFT. Defaults to $CROSSPROB_FFT_BACKEND, or else to the first one built in.\n";
+    cout << "\n";
+    cout << "    --low-memory\n";
+    cout << "        In ecdf2-ks2001 and ecdf2-mn2017, size the FFT buffers and Poisson PMF tables to the largest window between\n";
+    cout << "        the boundaries rather than to n. For large n with narrow boundaries this needs a fraction of the memory.\n";
+    cout << "\n";
+    cout << "    --verbose\n";
+    cout << "        With the auto algorithm, print the estimated running times and the chosen algorithm and why to stderr.\n";
+    cout << "\n";
+    cout << "    --tolerance=<t>\n";
+    cout << "        With the auto algorithm, the required precision: if the worst case round-off error bound of the chosen\n";
+    cout << "        algorithm (see --with-error) exceeds t, the probability is recomputed in double-double precision by ecdf2-dd.\n";
+    cout << "\n";
+    cout << "    --stats\n";
+    cout << "        Print the profiling counters to stderr: the wall time and number of calls of the PMF generation,\n";
+    cout << "        FFT and naive convolutions, rank-one corrections and sorting, and histograms of the convolution sizes.\n";
+    cout << "        Requires building with \"make clean; make STATS=1\".\n";
+    cout << "\n";
+    cout << "    --memory\n";
+    cout << "        Print the peak number of bytes allocated by the FFT buffers, Poisson PMF tables and probability vectors to stderr.\n";
+    cout << "\n";
+    cout << "    --with-error\n";
+    cout << "        With the ecdf1-new, ecdf2-* and auto algorithms, also print bounds on the round-off error of the probability:\n";
+    cout << "            error_bound: a worst case bound, from the round-off of every Poisson PMF, convolution and rank-one correction.\n";
+    cout << "            error_estimate: a conservative estimate of the actual error, taking these round-offs as independent\n";
+    cout << "                random errors. Usually much smaller than error_bound, but not guaranteed.\n";
+    cout << "        and the numbers of FFT and naive convolutions and of negative entries of the final Poisson state.\n";
+    cout << "        The probability is printed with 17 significant digits. --jump-size applies, --low-memory isn't supported.\n";
+    cout << "\n";
     cout << "EXAMPLES:\n";
     cout << "    To check the probability that\n";
     cout << "    X_(1)<=0.7 and 0.15<=X_(2)<=0.9 and 0.5<=X_(3)<= 0.7\n";
@@ -68,6 +177,9 @@ static void print_usage()
     cout << "            \n";
     cout << "    0.5, 0.7\n";
     cout << "\n";
+    cout << "    To find the 0.05-level critical value of the one-sided Berk-Jones M_n^+ statistic for n=1000, run\n";
+    cout << "        ./bin/crossprob threshold mn-plus 1000 0.05\n";
+    cout << "\n";
     cout << "REFERENCES\n";
     cout << "    [KS2001] Estate Khmaladze, Eka Shinjikashvili (2001). Calculation of noncrossing probabilities for Poisson\n";
     cout << "             processes and its corollaries, Advances in Applied Probability. https://doi.org/10.1239/aap/1005091361\n";
@@ -96,27 +208,35 @@ double calculate_ecdf1_new(const vector<double>& b, const vector<double>& B)
         return ecdf1_new_b(b);
     } else if ((b.size() == 0) && (B.size() > 0)) {
         return ecdf1_new_B(B);
+    } else if ((b.size() > 0) && (b.size() == B.size())) {
+        // The two-sided generalization of the same method.
+        return ecdf2_blocked(b, B);
     } else {
         print_usage();
-        throw runtime_error("Expecting EITHER a lower or an upper boundary function when using the 'ecdf1-m2020' command for computing a one-sided boundary crossing.\n");
+        throw runtime_error("Expecting either a lower or an upper boundary function, or both with the same length, when using the 'ecdf1-new' command.\n");
     }
 }
 
+static double run_ecdf2(const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    return low_memory ? ecdf2_low_memory(b, B, use_fft) : ecdf2(b, B, use_fft);
+}
+
 double calculate_ecdf2_ks2001(const vector<double>& b, const vector<double>& B)
 {
     int n = max(b.size(), B.size());
     if ((b.size() == n) && (B.size() == n)) {
-        return ecdf2(b, B, false);
+        return run_ecdf2(b, B, false);
     }
 
     if ((b.size() == 0) && (B.size() == n)) {
         std::vector<double> zeros_vector(n, 0.0);
-        return ecdf2(zeros_vector, B, false);
+        return run_ecdf2(zeros_vector, B, false);
     }
 
     if ((b.size() == n) && (B.size() == 0)) {
         std::vector<double> ones_vector(n, 1.0);
-        return ecdf2(b, ones_vector, false);
+        return run_ecdf2(b, ones_vector, false);
     }
 
     throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
@@ -126,33 +246,277 @@ double calculate_ecdf2_mn2017(const vector<double>& b, const vector<double>& B)
 {
     int n = max(b.size(), B.size());
     if ((b.size() == n) && (B.size() == n)) {
-        return ecdf2(b, B, true);
+        return run_ecdf2(b, B, true);
     }
 
     if ((b.size() == 0) && (B.size() == n)) {
         std::vector<double> zeros_vector(n, 0.0);
-        return ecdf2(zeros_vector, B, true);
+        return run_ecdf2(zeros_vector, B, true);
     }
 
     if ((b.size() == n) && (B.size() == 0)) {
         std::vector<double> ones_vector(n, 1.0);
-        return ecdf2(b, ones_vector, true);
+        return run_ecdf2(b, ones_vector, true);
+    }
+    throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
+}
+
+double calculate_ecdf2_blocked(const vector<double>& b, const vector<double>& B)
+{
+    int n = max(b.size(), B.size());
+    if (((int)b.size() == n) && ((int)B.size() == n)) {
+        return ecdf2_blocked(b, B);
+    }
+
+    if ((b.size() == 0) && ((int)B.size() == n)) {
+        std::vector<double> zeros_vector(n, 0.0);
+        return ecdf2_blocked(zeros_vector, B);
+    }
+
+    if (((int)b.size() == n) && (B.size() == 0)) {
+        std::vector<double> ones_vector(n, 1.0);
+        return ecdf2_blocked(b, ones_vector);
     }
     throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
 }
 
+double calculate_auto(const vector<double>& b, const vector<double>& B)
+{
+    if (verbose) {
+        vector<AlgorithmEstimate> estimates = estimate_running_times(b, B);
+        for (unsigned int j = 0; j < estimates.size(); ++j) {
+            cerr << "Estimated running time of " << estimates[j].algorithm << ": " << estimates[j].seconds << "s" << endl;
+        }
+        cerr << "Chosen algorithm: " << auto_algorithm_reason(b, B) << endl;
+    }
+    if (tolerance > 0.0) {
+        AutoResult result = ecdf_auto_with_tolerance(b, B, tolerance);
+        if (verbose) {
+            cerr << "Error bound: " << result.error_bound << ((result.algorithm == "ecdf2-dd") ? " exceeds" : " is within") << " the tolerance " << tolerance << endl;
+            cerr << "Computed by: " << result.algorithm << endl;
+        }
+        return result.probability;
+    }
+    return ecdf_auto(b, B);
+}
+
+static int handle_poisson_command(int argc, char* argv[])
+{
+    if (argc != 4) {
+        print_usage();
+        throw runtime_error("Expecting 2 arguments for the 'poisson' command: <intensity>[,<intensity>,...] <boundaries-filename>");
+    }
+    vector<double> intensities = read_comma_delimited_doubles(argv[2]);
+    pair<vector<double>, vector<double> > bounds = read_and_check_boundaries_file(argv[3]);
+    vector<double>& b = bounds.first;
+    const vector<double>& B = bounds.second;
+    if (b.size() == 0) {
+        b.assign(B.size(), 0.0);
+    }
+
+    vector<double> probabilities = poisson_noncrossing_probabilities(intensities, b, B, true);
+    for (unsigned int j = 0; j < probabilities.size(); ++j) {
+        cout << probabilities[j] << endl;
+    }
+
+    return 0;
+}
+
+static void read_warps_file(const string& filename, vector<vector<double> >& warps_x, vector<vector<double> >& warps_y)
+{
+    ifstream f(filename);
+    if (!f.is_open()) {
+        throw runtime_error("Unable to read input file '" + filename + "'");
+    }
+    string x_line, y_line;
+    while (getline(f, x_line)) {
+        if (!getline(f, y_line)) {
+            throw runtime_error("Expecting the warps file '" + filename + "' to have an even number of lines.");
+        }
+        warps_x.push_back(read_comma_delimited_doubles(x_line));
+        warps_y.push_back(read_comma_delimited_doubles(y_line));
+    }
+}
+
+static int handle_ecdf2_warped_command(int argc, char* argv[])
+{
+    if (argc != 4) {
+        print_usage();
+        throw runtime_error("Expecting 2 arguments for the 'ecdf2-warped' command: <warps-filename> <boundaries-filename>");
+    }
+    vector<vector<double> > warps_x, warps_y;
+    read_warps_file(argv[2], warps_x, warps_y);
+    pair<vector<double>, vector<double> > bounds = read_and_check_boundaries_file(argv[3]);
+    vector<double>& b = bounds.first;
+    vector<double>& B = bounds.second;
+    int n = max(b.size(), B.size());
+    if (b.size() == 0) {
+        b.assign(n, 0.0);
+    }
+    if (B.size() == 0) {
+        B.assign(n, 1.0);
+    }
+
+    vector<double> probabilities = ecdf2_warped(warps_x, warps_y, b, B, true);
+    for (unsigned int j = 0; j < probabilities.size(); ++j) {
+        cout << probabilities[j] << endl;
+    }
+
+    return 0;
+}
+
+static int handle_threshold_command(int argc, char* argv[])
+{
+    if (argc != 5) {
+        print_usage();
+        throw runtime_error("Expecting 3 arguments for the 'threshold' command: <boundary-family> <n> <alpha>");
+    }
+    string family = string(argv[2]);
+    long n = string_to_long(argv[3]);
+    double alpha = string_to_double(argv[4]);
+
+    double threshold = find_threshold(family, n, alpha);
+
+    cout.precision(17);
+    cout << threshold << endl;
+
+    return 0;
+}
+
+static int handle_crossing_command(int argc, char* argv[])
+{
+    if (argc != 5) {
+        print_usage();
+        throw runtime_error("Expecting 3 arguments for the 'crossing' command: <boundary-family> <n> <x>[,<x>,...]");
+    }
+    string family = string(argv[2]);
+    long n = string_to_long(argv[3]);
+    vector<double> thresholds = read_comma_delimited_doubles(argv[4]);
+
+    vector<double> probabilities = boundary_family_crossing_probabilities(family, n, thresholds);
+    for (unsigned int j = 0; j < probabilities.size(); ++j) {
+        cout << probabilities[j] << endl;
+    }
+
+    return 0;
+}
+
+static int handle_calibrate_command(int argc, char* argv[])
+{
+    if (argc > 3) {
+        print_usage();
+        throw runtime_error("Expecting at most 1 argument for the 'calibrate' command: [<max-window-size>]");
+    }
+    int max_window_size = (argc == 3) ? string_to_long(argv[2]) : 100000;
+    string filename = default_jump_size_calibration_filename();
+
+    vector<int> table = calibrate_jump_size(filename, max_window_size);
+    cout << "window_size jump_size\n";
+    for (unsigned int j = 0; j < table.size(); j += 2) {
+        cout << table[j] << " " << table[j+1] << "\n";
+    }
+    cout << "Saved to " << filename << endl;
+
+    return 0;
+}
+
+static int handle_batch_command(int argc, char* argv[])
+{
+    if (argc < 4) {
+        print_usage();
+        throw runtime_error("Expecting at least 2 arguments for the 'batch' command: <algorithm> <boundaries-filename> [<boundaries-filename> ...]");
+    }
+    string algorithm = string(argv[2]);
+    vector<vector<double> > b_list;
+    vector<vector<double> > B_list;
+    for (int i = 3; i < argc; ++i) {
+        pair<vector<double>, vector<double> > bounds = read_and_check_boundaries_file(argv[i]);
+        b_list.push_back(bounds.first);
+        B_list.push_back(bounds.second);
+    }
+
+    vector<double> results = ecdf_batch(algorithm, b_list, B_list, num_threads);
+    for (unsigned int j = 0; j < results.size(); ++j) {
+        cout << results[j] << endl;
+    }
+
+    return 0;
+}
+
+static int print_probability_with_error(const string& algorithm, const vector<double>& b, const vector<double>& B)
+{
+    if ((algorithm != "ecdf1-new") && (algorithm != "ecdf2-ks2001") && (algorithm != "ecdf2-mn2017") && (algorithm != "ecdf2-blocked") && (algorithm != "auto")) {
+        throw runtime_error("--with-error expects one of the algorithms 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked', 'auto'.");
+    }
+    ProbabilityWithError result = ecdf_with_error(algorithm, b, B);
+    cout << setprecision(17) << result.probability << endl;
+    cout << setprecision(6) << "error_bound " << result.error_bound << endl;
+    cout << "error_estimate " << result.error_estimate << endl;
+    cout << "fft_convolutions " << result.fft_convolutions << endl;
+    cout << "naive_convolutions " << result.naive_convolutions << endl;
+    cout << "negative_entries " << result.negative_entries << endl;
+    return 0;
+}
+
 static int handle_command_line_arguments(int argc, char* argv[])
 {
     string command = string(argv[1]);
-
+    if ((tolerance > 0.0) && ((command != "auto") || with_error)) {
+        throw runtime_error("--tolerance only applies to the auto algorithm, without --with-error.");
+    }
+    if (with_error && low_memory) {
+        throw runtime_error("--with-error doesn't support --low-memory.");
+    }
+    if (with_error && ((command == "calibrate") || (command == "poisson") || (command == "ecdf2-warped") || (command == "threshold") || (command == "crossing") || (command == "batch"))) {
+        throw runtime_error("--with-error expects one of the algorithms 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked', 'auto'.");
+    }
+    if (command == "calibrate") {
+        return handle_calibrate_command(argc, argv);
+    }
+    if (command == "poisson") {
+        return handle_poisson_command(argc, argv);
+    }
+    if (command == "ecdf2-warped") {
+        return handle_ecdf2_warped_command(argc, argv);
+    }
+    if (command == "threshold") {
+        return handle_threshold_command(argc, argv);
+    }
+    if (command == "crossing") {
+        return handle_crossing_command(argc, argv);
+    }
+    if (command == "batch") {
+        return handle_batch_command(argc, argv);
+    }
+    if (argc != 3) {
+        print_usage();
+        throw runtime_error("Expecting 2 command line arguments!");
+    }
 
     string filename = string(argv[2]);
     pair<vector<double>, vector<double> > bounds = read_and_check_boundaries_file(filename);
     const vector<double>& b = bounds.first;
     const vector<double>& B = bounds.second;
 
+    if (with_error) {
+        return print_probability_with_error(command, b, B);
+    }
+
 
 
+    if (command == "ecdf2-reference") {
+        int n = max(b.size(), B.size());
+        cout << ecdf2_reference_string(b.empty() ? vector<double>(n, 0.0) : b, B.empty() ? vector<double>(n, 1.0) : B) << endl;
+        return 0;
+    }
+    if (command == "ecdf2-dd") {
+        int n = max(b.size(), B.size());
+        DoubleDoubleProbability result = ecdf2_dd(b.empty() ? vector<double>(n, 0.0) : b, B.empty() ? vector<double>(n, 1.0) : B);
+        cout << setprecision(17) << result.noncrossing_probability << endl;
+        cout << result.crossing_probability << endl;
+        return 0;
+    }
+
     double result;
     if (command == "ecdf1-mns2016") {
         result = calculate_ecdf1_mns2016(b, B);
@@ -163,9 +527,13 @@ static int handle_command_line_arguments(int argc, char* argv[])
     } else if (command == "ecdf2-mn2017") {
 
         result = calculate_ecdf2_mn2017(b, B);
+    } else if (command == "ecdf2-blocked") {
+        result = calculate_ecdf2_blocked(b, B);
+    } else if (command == "auto") {
+        result = calculate_auto(b, B);
     } else {
         print_usage();
-        throw runtime_error("Second command line argument must be one of: 'ecdf1-mns2016', 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017'.");
+        throw runtime_error("Second command line argument must be one of: 'ecdf1-mns2016', 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked', 'auto', 'ecdf2-reference', 'ecdf2-dd', 'ecdf2-warped', 'poisson', 'threshold', 'crossing', 'calibrate', 'batch'.");
     }
 
     cout << result << endl;
@@ -173,15 +541,79 @@ static int handle_command_line_arguments(int argc, char* argv[])
     return 0;
 }
 
+// Removes the options from argv.
+static void handle_options(int& argc, char* argv[])
+{
+    const string JUMP_SIZE_OPTION = "--jump-size=";
+    const string THREADS_OPTION = "--threads=";
+    const string FFT_OPTION = "--fft=";
+    const string TOLERANCE_OPTION = "--tolerance=";
+    int j = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = string(argv[i]);
+        if (arg.compare(0, JUMP_SIZE_OPTION.size(), JUMP_SIZE_OPTION) == 0) {
+            set_jump_size(string_to_long(arg.substr(JUMP_SIZE_OPTION.size())));
+        } else if (arg.compare(0, THREADS_OPTION.size(), THREADS_OPTION) == 0) {
+            num_threads = string_to_long(arg.substr(THREADS_OPTION.size()));
+        } else if (arg.compare(0, TOLERANCE_OPTION.size(), TOLERANCE_OPTION) == 0) {
+            tolerance = string_to_double(arg.substr(TOLERANCE_OPTION.size()));
+            if (!(tolerance > 0.0)) {
+                throw runtime_error("Expecting a positive --tolerance.");
+            }
+        } else if (arg.compare(0, FFT_OPTION.size(), FFT_OPTION) == 0) {
+            set_fft_backend(arg.substr(FFT_OPTION.size()));
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else if (arg == "--stats") {
+            print_stats = true;
+        } else if (arg == "--low-memory") {
+            low_memory = true;
+        } else if (arg == "--memory") {
+            print_memory = true;
+        } else if (arg == "--with-error") {
+            with_error = true;
+        } else {
+            argv[j++] = argv[i];
+        }
+    }
+    argc = j;
+}
+
+static void print_profiling_stats()
+{
+    if (!profiling_stats_enabled()) {
+        cerr << "Profiling counters are not compiled in. Rebuild with \"make clean; make STATS=1\"." << endl;
+        return;
+    }
+    map<string, double> stats = get_profiling_stats();
+    for (map<string, double>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        cerr << it->first << " " << it->second << endl;
+    }
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc != 3) {
+    try {
+        handle_options(argc, argv);
+    } catch (runtime_error& e) {
+        cout << "Error:" << endl;
+        cout << e.what() << endl;
+        return 3;
+    }
+    if ((argc < 3) && !((argc == 2) && (string(argv[1]) == "calibrate"))) {
         print_usage();
-        cout << "Error: Expecting 2 command line arguments!" << endl;
+        cout << "Error: Expecting at least 2 command line arguments!" << endl;
         return 1;
     }
     try {
+        reset_profiling_stats();
         handle_command_line_arguments(argc, argv);
+        if (print_stats) {
+            print_profiling_stats();
+        }
+        if (print_memory) {
+            cerr << "peak_allocated_bytes " << peak_allocated_bytes() << endl;
+        }
         return 0;
     } catch (ifstream::failure& e) {
         cout << "ifstream::failure exception caught:" << endl;
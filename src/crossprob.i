@@ -1,6 +1,7 @@
 // This is a SWIG interface file for wrapping the C++ code to make it available in other languagses.
 //
-// The python extension is under python_extension/crossprob_swig_wrap.cc, to rebuild it install SWIG and run "make python".
+// The python extension is generated from this file into python_extension/crossprob.cc and python_extension/crossprob.py
+// by "swig -c++ -threads". To build it install SWIG and run "make python", which regenerates them when this file or a header changes.
 
 %define DOCSTRING
 "crossprob - crossing probabilities for one-dimensional empirical processes
@@ -23,6 +24,25 @@ Its parameters are:
     b, B: two lists of length n of the boundaries in Eq. (1) above.
     use_fft: If true algorithm the O(n^2 logn) algorithm [MNS2016] is used,
              otherwise the O(n^3) algorithm of [KS2001]
+    ecdf2_blocked(b, B)
+        Same as ecdf2(b, B, True) using an O(n^2) algorithm that processes about sqrt(w) steps of
+        the boundaries per large FFT convolution of the w active counts, similar to ecdf1_new_B().
+        Much faster than ecdf2() for two-sided bounds with a narrow window, such as Kolmogorov-Smirnov.
+    ecdf2_low_memory(b, B, use_fft)
+        Same as ecdf2(b, B, use_fft), with the FFT buffers sized to the largest window between the boundaries
+        rather than to n. For large n with narrow boundaries this needs a fraction of the memory.
+    ecdf2_reference(b, B)
+        Same as ecdf2(b, B, True) computed in quadruple precision, for measuring the round-off errors of the
+        other functions. About 100 times slower. ecdf2_reference_string(b, B) gives 30 significant digits.
+    ecdf2_dd(b, B)
+        Same as ecdf2(b, B, True) computed in double-double precision (about 32 digits), 5-10 times slower.
+        The result has the attributes noncrossing_probability and crossing_probability. The latter is
+        1 - noncrossing_probability computed before rounding, so it stays accurate far below 1e-16.
+    ecdf_with_error(algorithm, b, B)
+        The probability computed by one of 'auto', 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked',
+        with bounds on its round-off error. The result has the attributes probability, error_bound (a worst case
+        bound), error_estimate (a conservative estimate of the actual error, but not a bound), fft_convolutions,
+        naive_convolutions and negative_entries.
 
 Faster functions are available for the special case of a single boundary:
     ecdf1_new_b(b)
@@ -36,6 +56,112 @@ Faster functions are available for the special case of a single boundary:
         Implements the O(n^2) algorithm of [MNS2016]. b_i are implicitly assumed to be 0. 
         Generally slower and less numerically stable than ecdf1_new_B()
 
+Poisson processes:
+    poisson_noncrossing_probability(intensity, b, B, use_fft)
+        The probability that the arrival times T_1 <= T_2 <= ... of a homogeneous Poisson process on [0,1]
+        satisfy b_i <= T_i for i=1,...,len(b) and T_i <= B_i for i=1,...,len(B), where len(B) <= len(b).
+        In particular the process has at most len(b) arrivals.
+    poisson_noncrossing_probability_by_count(intensity, b, B, use_fft)
+        Same as above, split by the number of arrivals k=0,...,len(b).
+    poisson_noncrossing_probabilities(intensities, b, B, use_fft)
+    poisson_noncrossing_probabilities_by_count(intensities, b, B, use_fft)
+        Same as above for a list of intensities, computed in a single pass over the bounds.
+
+Non-uniform samples and non-homogeneous Poisson processes are supported through warps. A warp is a
+piecewise linear function given by two lists x, y of the same length. If x is empty, the values
+y are taken on a uniform grid over [0,1]:
+    ecdf2_warped(warp_x, warp_y, b, B, use_fft)
+        Same as ecdf2(b, B, use_fft) for a sample drawn from the distribution with CDF warp(t).
+    ecdf2_warped(warps_x, warps_y, b, B, use_fft)
+        Same as above for a list of warps, computed in a single pass over the bounds.
+    poisson_noncrossing_probabilities_warped(warps_x, warps_y, b, B, use_fft)
+    poisson_noncrossing_probabilities_by_count_warped(warps_x, warps_y, b, B, use_fft)
+        Same as poisson_noncrossing_probabilities() for Poisson processes whose cumulative intensities are the warps.
+
+The noncrossing probabilities of many related boundaries can be computed in one go:
+    ecdf2_all_sample_sizes(b, B, use_fft)
+        Returns a list whose m-th entry is ecdf2(b[:m], B[:m], use_fft), for m=0,...,n.
+    ecdf2_prefix_noncrossing_probabilities(b, B, use_fft, t)
+        Returns a list whose j-th entry is the probability that the empirical CDF does not cross
+        the boundaries in the interval [0, t[j]]. The list t must be sorted.
+
+Critical values of goodness-of-fit statistics can be computed using
+    find_threshold(family, n, alpha)
+        Returns the threshold x at which the boundaries of the given family have crossing probability alpha.
+        family is one of "ks-plus", "ks-minus", "ks", "mn-plus", "mn-minus", "mn".
+    boundary_family_crossing_probability(family, n, x)
+        The crossing probability of the boundaries of the given family at threshold x.
+    boundary_family_crossing_probabilities(family, n, x_list)
+        The crossing probabilities at each threshold in x_list, sharing the FFT plans and Poisson PMF tables.
+
+If unsure which of the above to use, the fastest one for the given boundaries is chosen automatically by
+    auto(b, B)
+        Computes the non-crossing probability. b or B may be an empty list for one-sided boundaries.
+    auto_algorithm(b, B)
+        The name of the algorithm used by auto(b, B), e.g. "ecdf2-blocked".
+    auto_algorithm_reason(b, B)
+        The same followed by the reason for choosing it.
+    ecdf_auto_with_tolerance(b, B, tolerance)
+        Same as auto(b, B), recomputed by ecdf2_dd() if the error_bound of ecdf_with_error() exceeds tolerance.
+        The result has the attributes probability, algorithm ("ecdf2-dd" if recomputed) and error_bound.
+    estimate_running_times(b, B)
+        The estimated running times of the applicable algorithms, fastest first.
+
+NumPy arrays are passed to the following functions without converting them element by element, which matters for large n:
+    ecdf2_array(b, B, use_fft=True), ecdf2_blocked_array(b, B), ecdf1_new_b_array(b), ecdf1_new_B_array(B)
+        Same as the functions above. b and B are converted to contiguous float64 arrays if they aren't already,
+        and their memory is then used in place, except that ecdf1_new_b_array() makes one copy of b reflected
+        into lower bounds, as ecdf1_new_b() does.
+    poisson_noncrossing_probability_by_count_array(intensity, b, B, use_fft=True)
+        Same as poisson_noncrossing_probability_by_count(), returning a NumPy array.
+
+All the functions release the GIL while computing, so calls from several Python threads run in parallel.
+The arrays passed to the *_array functions must not be modified by other threads during the call.
+
+Batches of boundaries are computed on a pool of native threads, which share the FFT plans:
+    Pool(num_threads=0, algorithm='auto')
+        num_threads=0 uses one thread per core. algorithm is one of 'auto', 'ecdf1-new', 'ecdf1-mns2016',
+        'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked'. Use close() or a with statement to stop the pool.
+    Pool.map(b, B)
+        The non-crossing probabilities as a NumPy array. b and B are 2-D arrays with one boundary per row,
+        or lists of 1-D arrays of any lengths. Either may be None for one-sided boundaries.
+    Pool.map_async(b, B)
+        Same as map(), returning a concurrent.futures.Future of the array.
+    Pool.submit(b, B)
+        A concurrent.futures.Future of the non-crossing probability of a single boundary.
+    ecdf_batch(algorithm, b_list, B_list, num_threads)
+        Same as Pool(num_threads, algorithm).map(b_list, B_list) for lists of lists, returning a list.
+
+When the module is built with CROSSPROB_STATS=1 in the environment, profiling counters are available:
+    get_profiling_stats()
+        A dict of the wall time and number of calls of the PMF generation, FFT and naive convolutions, rank-one
+        corrections and sorting since the last reset, and histograms of the convolution sizes.
+    reset_profiling_stats()
+    profiling_stats_enabled()
+
+The memory of the large buffers (FFT buffers, Poisson PMF tables and probability vectors) is tracked by
+    peak_allocated_bytes()
+        The largest number of bytes allocated at once since the last reset_peak_allocated_bytes().
+    reset_peak_allocated_bytes()
+
+The number of boundary steps that ecdf1_new_b(), ecdf1_new_B() and ecdf2_blocked() process per large FFT (the jump size)
+is tuned for the current machine:
+    calibrate_jump_size(filename, max_window_size)
+        Measures the convolution costs and saves a table of the best jump size per window size to filename.
+        The table in $CROSSPROB_CALIBRATION_FILE or $HOME/.crossprob_calibration is loaded automatically.
+    load_jump_size_calibration(filename)
+        Uses the table saved in filename.
+    set_jump_size(k)
+        Uses a fixed jump size k. set_jump_size(0) restores the automatic choice.
+
+The FFT library of the convolutions may be chosen at runtime:
+    available_fft_backends()
+        The backends of this build: 'fftw' (or 'mkl' when built with CROSSPROB_FFT=mkl in the environment) and
+        'builtin', a self-contained split-radix FFT. Building with CROSSPROB_FFT=builtin leaves only the latter.
+    set_fft_backend(name)
+        Used by the computations started afterwards. Defaults to $CROSSPROB_FFT_BACKEND, or else to the first one.
+    get_fft_backend()
+
 EXAMPLES
     For a sample X_1, X_2, X_3 with order statistics X_(1) <= X_(2) <= X(3), the probability
         Pr[X_(1)<=0.7 and 0.15<=X_(2)<=0.9 and 0.5<=X_(3)<=0.8]
@@ -59,8 +185,14 @@ MODULE REFERENCE
 
 
 %include "std_vector.i"
+%include "std_string.i"
+%include "std_map.i"
 namespace std {
    %template(VectorDouble) vector<double>;
+   %template(VectorVectorDouble) vector<vector<double> >;
+   %template(VectorInt) vector<int>;
+   %template(VectorString) vector<string>;
+   %template(MapStringDouble) map<string, double>;
 };
 
 %exception {
@@ -77,12 +209,213 @@ namespace std {
 
 %{
 #include "../src/ecdf2.hh"
+#include "../src/ecdf2_blocked.hh"
 #include "../src/ecdf1_mns2016.hh"
 #include "../src/ecdf1_new.hh"
+#include "../src/threshold_search.hh"
+#include "../src/jump_size.hh"
+#include "../src/ecdf_auto.hh"
+#include "../src/profiling.hh"
+#include "../src/memory_usage.hh"
+#include "../src/array_interface.hh"
+#include "../src/batch.hh"
+#include "../src/fftwconvolver.hh"
+#include "../src/ecdf2_reference.hh"
+#include "../src/error_estimate.hh"
+#include "../src/double_double.hh"
 %}
 
+%ignore find_threshold(const BoundaryFamily& family, int n, double alpha);
+%rename(auto) ecdf_auto;
+%rename(_get_profiling_stats) get_profiling_stats;
+%ignore add_allocated_bytes;
+%ignore ScopedAllocation;
+%ignore ErrorTracker;
+%ignore convolve_same_size_dd;
+%ignore PoissonPMFGeneratorDD;
+%ignore poisson_process_noncrossing_probability(int, double, const double*, int, const double*, int, bool, ComputationContext&);
+%ignore poisson_process_noncrossing_probability_blocked(int, double, const double*, int, const double*, int, int, ComputationContext&);
+%ignore ecdf1_new_B(const double*, int, ComputationContext&);
+%ignore poisson_B_noncrossing_probability_n2(int, double, const double*, int, int, ComputationContext&);
+%rename(_ecdf2_array) ecdf2_array;
+%rename(_ecdf2_blocked_array) ecdf2_blocked_array;
+%rename(_ecdf1_new_b_array) ecdf1_new_b_array;
+%rename(_ecdf1_new_B_array) ecdf1_new_B_array;
+%rename(_poisson_noncrossing_probability_by_count_array) poisson_noncrossing_probability_by_count_array;
+%rename(_ecdf_batch_array) ecdf_batch_array;
+
+// The array entry points of array_interface.hh use the memory of any C-contiguous buffer of doubles
+// (e.g. a float64 NumPy array) through the buffer protocol, without copying it.
+%typemap(in) (const double* IN_ARRAY, int IN_SIZE) (Py_buffer view) {
+    if (PyObject_GetBuffer($input, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        SWIG_fail;
+    }
+    if ((view.itemsize != sizeof(double)) || (view.format == NULL) || (view.format[strlen(view.format)-1] != 'd')) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_TypeError, "Expecting a contiguous buffer of float64 values.");
+        SWIG_fail;
+    }
+    $1 = static_cast<const double*>(view.buf);
+    $2 = view.len / sizeof(double);
+}
+%typemap(freearg) (const double* IN_ARRAY, int IN_SIZE) {
+    if ($1 != NULL) {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+%typemap(in) (double* OUT_ARRAY, int OUT_SIZE) (Py_buffer view) {
+    if (PyObject_GetBuffer($input, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT | PyBUF_WRITABLE) != 0) {
+        SWIG_fail;
+    }
+    if ((view.itemsize != sizeof(double)) || (view.format == NULL) || (view.format[strlen(view.format)-1] != 'd')) {
+        PyBuffer_Release(&view);
+        PyErr_SetString(PyExc_TypeError, "Expecting a writable contiguous buffer of float64 values.");
+        SWIG_fail;
+    }
+    $1 = static_cast<double*>(view.buf);
+    $2 = view.len / sizeof(double);
+}
+%typemap(freearg) (double* OUT_ARRAY, int OUT_SIZE) {
+    if ($1 != NULL) {
+        PyBuffer_Release(&view$argnum);
+    }
+}
+%apply (const double* IN_ARRAY, int IN_SIZE) {(const double* b, int b_size), (const double* B, int B_size)};
+%apply (double* OUT_ARRAY, int OUT_SIZE) {(double* out, int out_size)};
+
 %feature("autodoc", "1");
 %include "../src/ecdf2.hh"
+%include "../src/ecdf2_blocked.hh"
 %include "../src/ecdf1_mns2016.hh"
 %include "../src/ecdf1_new.hh"
+%include "../src/threshold_search.hh"
+%include "../src/jump_size.hh"
+%include "../src/ecdf_auto.hh"
+%include "../src/profiling.hh"
+%include "../src/memory_usage.hh"
+%include "../src/array_interface.hh"
+%include "../src/batch.hh"
+%include "../src/ecdf2_reference.hh"
+%include "../src/error_estimate.hh"
+%include "../src/double_double.hh"
+// Only the backend selection of fftwconvolver.hh, not the convolver itself.
+std::vector<std::string> available_fft_backends();
+void set_fft_backend(const std::string& name);
+std::string get_fft_backend();
 
+namespace std {
+   %template(VectorAlgorithmEstimate) vector<AlgorithmEstimate>;
+};
+
+%pythoncode %{
+def get_profiling_stats():
+    """The profiling counters accumulated since the last reset_profiling_stats(), as a dict."""
+    return dict(_get_profiling_stats())
+
+def _as_float64_array(x):
+    import numpy
+    return numpy.ascontiguousarray(x, dtype=numpy.float64)
+
+def ecdf2_array(b, B, use_fft=True):
+    """Same as ecdf2(b, B, use_fft), passing the memory of NumPy arrays without copying it."""
+    return _ecdf2_array(_as_float64_array(b), _as_float64_array(B), use_fft)
+
+def ecdf2_blocked_array(b, B):
+    """Same as ecdf2_blocked(b, B), passing the memory of NumPy arrays without copying it."""
+    return _ecdf2_blocked_array(_as_float64_array(b), _as_float64_array(B))
+
+def ecdf1_new_b_array(b):
+    """Same as ecdf1_new_b(b) for a NumPy array."""
+    return _ecdf1_new_b_array(_as_float64_array(b))
+
+def ecdf1_new_B_array(B):
+    """Same as ecdf1_new_B(B) for a NumPy array."""
+    return _ecdf1_new_B_array(_as_float64_array(B))
+
+def poisson_noncrossing_probability_by_count_array(intensity, b, B, use_fft=True):
+    """Same as poisson_noncrossing_probability_by_count(intensity, b, B, use_fft), returning a NumPy array."""
+    import numpy
+    b = _as_float64_array(b)
+    out = numpy.empty(len(b)+1)
+    _poisson_noncrossing_probability_by_count_array(intensity, b, _as_float64_array(B), use_fft, out)
+    return out
+
+def _as_boundary_rows(x):
+    import numpy
+    if isinstance(x, numpy.ndarray):
+        if x.ndim != 2:
+            raise ValueError('Expecting a 2-D array with one boundary per row, or a list of 1-D arrays.')
+        return _as_float64_array(x)
+    return [numpy.asarray(row, dtype=numpy.float64).reshape(-1) for row in x]
+
+def _concatenate_bounds(b, B):
+    """Stores a batch of boundaries back to back. b and B are 2-D arrays with one boundary per row, lists of 1-D arrays,
+    or None for one-sided boundaries. Returns the two concatenated float64 arrays and the offsets of the boundaries."""
+    import numpy
+    if (b is None) and (B is None):
+        raise ValueError('Expecting at least one of b and B.')
+    b_rows = None if b is None else _as_boundary_rows(b)
+    B_rows = None if B is None else _as_boundary_rows(B)
+    lengths = [len(row) for row in (B_rows if b_rows is None else b_rows)]
+    if (b_rows is not None) and (B_rows is not None) and (lengths != [len(row) for row in B_rows]):
+        raise ValueError('Expecting lower and upper boundaries of the same lengths.')
+    offsets = [0] + numpy.cumsum(lengths, dtype=numpy.int64).tolist()
+    def concatenate(rows, fill_value):
+        if rows is None:
+            return numpy.full(offsets[-1], fill_value)
+        if isinstance(rows, numpy.ndarray):
+            return rows.reshape(-1)
+        return numpy.concatenate(rows) if len(rows) > 0 else numpy.empty(0)
+    return concatenate(b_rows, 0.0), concatenate(B_rows, 1.0), offsets
+
+class Pool:
+    """A pool of native threads that computes the non-crossing probabilities of many boundaries.
+
+    The boundaries are passed to the threads as NumPy memory, without pickling, and all the threads share
+    the FFT plans. Pool(num_threads=0, algorithm='auto') uses one thread per core, algorithm is as in the
+    command line tool: 'auto', 'ecdf1-new', 'ecdf1-mns2016', 'ecdf2-ks2001', 'ecdf2-mn2017' or 'ecdf2-blocked'.
+
+        map(b, B)           The non-crossing probabilities of a batch as a NumPy array. b and B are either 2-D arrays
+                            with one boundary per row (boundaries of equal n) or lists of 1-D arrays. Either may be
+                            None for one-sided boundaries.
+        map_async(b, B)     Same as map(), returning a concurrent.futures.Future of the array.
+        submit(b, B)        A concurrent.futures.Future of the non-crossing probability of a single boundary.
+
+    The GIL is released while computing, so the calling thread is free until the result is needed.
+    Use close() or a with statement to stop the pool."""
+
+    def __init__(self, num_threads=0, algorithm='auto'):
+        import os
+        import concurrent.futures
+        self.num_threads = num_threads if num_threads > 0 else (os.cpu_count() or 1)
+        self.algorithm = algorithm
+        self._executor = concurrent.futures.ThreadPoolExecutor(max_workers=self.num_threads)
+
+    def map(self, b, B):
+        return self._map(b, B, self.num_threads)
+
+    def map_async(self, b, B):
+        return self._executor.submit(self._map, b, B, self.num_threads)
+
+    def submit(self, b, B):
+        import numpy
+        b = None if b is None else [numpy.asarray(b, dtype=numpy.float64)]
+        B = None if B is None else [numpy.asarray(B, dtype=numpy.float64)]
+        return self._executor.submit(lambda: self._map(b, B, 1)[0])
+
+    def _map(self, b, B, num_threads):
+        import numpy
+        (b_values, B_values, offsets) = _concatenate_bounds(b, B)
+        out = numpy.empty(len(offsets)-1)
+        _ecdf_batch_array(self.algorithm, b_values, B_values, offsets, num_threads, out)
+        return out
+
+    def close(self):
+        self._executor.shutdown()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+%}
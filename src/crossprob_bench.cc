@@ -0,0 +1,719 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <atomic>
+
+#include "string_utils.hh"
+#include "common.hh"
+#include "fftwconvolver.hh"
+#include "poisson_pmf.hh"
+#include "polynomial_translated_monomials.hh"
+#include "boundary_families.hh"
+#include "ecdf1_mns2016.hh"
+#include "ecdf1_new.hh"
+#include "ecdf2.hh"
+#include "ecdf2_blocked.hh"
+#include "ecdf_auto.hh"
+#include "ecdf2_reference.hh"
+#include "computation_context.hh"
+#include "checkpoints.hh"
+
+using namespace std;
+
+static void print_usage()
+{
+    cout << "SYNOPSIS\n";
+    cout << "    crossprob_bench [--corpus [--reference]] [--format=csv|json] [--filter=<substring>] [--max-n=<n>] [--min-time=<seconds>] [--min-samples=<k>] [--fft=<backend>]\n";
+    cout << "    crossprob_bench --stress=<threads> [--filter=<substring>] [--max-n=<n>]\n";
+    cout << "    crossprob_bench --check [--filter=<substring>]\n";
+    cout << "\n";
+    cout << "DESCRIPTION\n";
+    cout << "    Times the convolution and Poisson PMF kernels and the full algorithms of crossprob over a sweep of sizes.\n";
+    cout << "    Each benchmark is repeated for at least <min-time> seconds (default 0.1) and at least <min-samples> times (default 5).\n";
+    cout << "    Fast kernels are timed in batches of calls, so that each sample takes at least 10 microseconds.\n";
+    cout << "    Prints one record per benchmark and size with the median and 99th percentile time per call\n";
+    cout << "    in nanoseconds, and the throughput in items (array entries, or n for the algorithms) per second.\n";
+    cout << "\n";
+    cout << "OPTIONS\n";
+    cout << "    --corpus\n";
+    cout << "        Instead, times the algorithms on the fixed corpus of boundaries of the regression suite\n";
+    cout << "        (benchmarks/regression.py): constant-KS, Berk-Jones, higher-criticism and random monotone bounds,\n";
+    cout << "        one-sided and two-sided, for n=100,1000,10000 up to <max-n>. The records also contain the computed\n";
+    cout << "        probability and, in JSON, the time of each of up to 200 samples.\n";
+    cout << "    --reference\n";
+    cout << "        With --corpus, also computes each probability with the quad precision reference engine (ecdf2-reference,\n";
+    cout << "        which is not timed). Takes several minutes per case of n=10000.\n";
+    cout << "    --stress=<threads>\n";
+    cout << "        Instead, runs the corpus cases, ecdf1-mns2016 and ecdf2-ks2001 concurrently on the given number of threads,\n";
+    cout << "        and checks that the results are identical to those of a single-threaded run. Exits with status 1 otherwise.\n";
+    cout << "    --check\n";
+    cout << "        Instead, checks the library functions that the crossprob command doesn't reach against the plain\n";
+    cout << "        algorithms, at sizes that use FFT convolutions. Prints the largest difference of each check and\n";
+    cout << "        exits with status 1 if any of them is above its tolerance.\n";
+    cout << "    --format=csv|json\n";
+    cout << "        Output format, default csv.\n";
+    cout << "    --filter=<substring>\n";
+    cout << "        Only run the benchmarks whose name contains the substring, e.g. --filter=ecdf1-new.\n";
+    cout << "    --max-n=<n>\n";
+    cout << "        Largest n of the full algorithms (default 10000). The kernels go up to 16*n.\n";
+    cout << "    --min-time=<seconds>\n";
+    cout << "        Minimum total running time of each benchmark.\n";
+    cout << "    --min-samples=<k>\n";
+    cout << "        Minimum number of samples of each benchmark.\n";
+    cout << "    --fft=<backend>\n";
+    cout << "        The FFT backend of all the benchmarks except convolver_<backend>, which times each available backend.\n";
+}
+
+struct BenchmarkOptions {
+    bool corpus;
+    bool reference;
+    string format;
+    string filter;
+    int max_n;
+    double min_seconds;
+    int min_samples;
+    int stress_threads;
+    bool check;
+};
+
+struct BenchmarkResult {
+    string name;
+    int size;
+    int samples;
+    double median_ns;
+    double p99_ns;
+    double items_per_second;
+    double value;  // The probability computed by an algorithm, NaN for the kernels.
+    double reference;  // The probability computed by ecdf2_reference() with --reference, otherwise NaN.
+    vector<double> samples_ns;
+};
+
+const double MINIMUM_SAMPLE_SECONDS = 1e-5;
+const int MAXIMUM_SAMPLES = 100000;
+// Keeps the samples of the corpus records, which are stored in the regression baseline, short.
+const int MAXIMUM_CORPUS_SAMPLES = 200;
+
+static double seconds_since(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Times f() repeatedly. Each sample runs f() batch times, where batch is chosen by a warm-up run.
+static BenchmarkResult run_benchmark(const string& name, int size, const function<void()>& f, const BenchmarkOptions& options)
+{
+    chrono::steady_clock::time_point warmup_start = chrono::steady_clock::now();
+    f();
+    double warmup_seconds = seconds_since(warmup_start);
+    int batch = (warmup_seconds >= MINIMUM_SAMPLE_SECONDS) ? 1 : int(MINIMUM_SAMPLE_SECONDS / max(warmup_seconds, 1e-9)) + 1;
+
+    vector<double> ns_per_call;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int maximum_samples = options.corpus ? MAXIMUM_CORPUS_SAMPLES : MAXIMUM_SAMPLES;
+    while ((((int)ns_per_call.size() < options.min_samples) || (seconds_since(start) < options.min_seconds)) && ((int)ns_per_call.size() < maximum_samples)) {
+        chrono::steady_clock::time_point sample_start = chrono::steady_clock::now();
+        for (int j = 0; j < batch; ++j) {
+            f();
+        }
+        ns_per_call.push_back(1e9 * seconds_since(sample_start) / batch);
+    }
+
+    BenchmarkResult result;
+    result.samples_ns = ns_per_call;
+    sort(ns_per_call.begin(), ns_per_call.end());
+    result.name = name;
+    result.size = size;
+    result.samples = ns_per_call.size();
+    result.median_ns = ns_per_call[ns_per_call.size()/2];
+    result.p99_ns = ns_per_call[min(ns_per_call.size()-1, (size_t)ceil(0.99*ns_per_call.size())-1)];
+    result.items_per_second = 1e9 * size / result.median_ns;
+    result.value = numeric_limits<double>::quiet_NaN();
+    result.reference = numeric_limits<double>::quiet_NaN();
+    return result;
+}
+
+static void print_header(const BenchmarkOptions& options)
+{
+    if (options.format == "csv") {
+        cout << "benchmark,size,samples,median_ns,p99_ns,items_per_second" << (options.corpus ? ",result" : "") << (options.reference ? ",reference" : "") << endl;
+    } else {
+        cout << "[";
+    }
+}
+
+static void print_result(const BenchmarkResult& r, bool first, const BenchmarkOptions& options)
+{
+    if (options.format == "csv") {
+        cout << r.name << "," << r.size << "," << r.samples << "," << r.median_ns << "," << r.p99_ns << "," << r.items_per_second;
+        if (options.corpus) {
+            cout.precision(17);
+            cout << "," << r.value;
+            if (options.reference) {
+                cout << "," << r.reference;
+            }
+            cout.precision(6);
+        }
+        cout << endl;
+    } else {
+        cout << (first ? "\n" : ",\n");
+        cout << "  {\"benchmark\": \"" << r.name << "\", \"size\": " << r.size << ", \"samples\": " << r.samples;
+        cout << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns << ", \"items_per_second\": " << r.items_per_second;
+        if (options.corpus) {
+            cout.precision(17);
+            cout << ", \"result\": " << r.value;
+            if (options.reference) {
+                cout << ", \"reference\": " << r.reference;
+            }
+            cout.precision(6);
+            cout << ", \"samples_ns\": [";
+            for (unsigned int j = 0; j < r.samples_ns.size(); ++j) {
+                cout << (j > 0 ? ", " : "") << r.samples_ns[j];
+            }
+            cout << "]";
+        }
+        cout << "}";
+        cout.flush();
+    }
+}
+
+static void print_footer(const BenchmarkOptions& options)
+{
+    if (options.format == "json") {
+        cout << "\n]" << endl;
+    }
+}
+
+// Sizes 16, 32, 64, ... up to max_size, plus the sizes around the threshold of the FFT convolution.
+static vector<int> kernel_sizes(int max_size)
+{
+    vector<int> sizes;
+    for (int size = 16; size <= max_size; size *= 2) {
+        sizes.push_back(size);
+        if (size == 64) {
+            sizes.push_back(127);
+        }
+    }
+    return sizes;
+}
+
+// Sample sizes 10, 30, 100, 300, ... up to max_n.
+static vector<int> algorithm_sizes(int max_n)
+{
+    vector<int> sizes;
+    for (int n = 10; n <= max_n; n *= 10) {
+        sizes.push_back(n);
+        if (3*n <= max_n) {
+            sizes.push_back(3*n);
+        }
+    }
+    return sizes;
+}
+
+// Fills in an empty b with zeros and an empty B with ones.
+static void complete_bounds(int n, vector<double>& b, vector<double>& B)
+{
+    if (b.empty()) {
+        b.assign(n, 0.0);
+    }
+    if (B.empty()) {
+        B.assign(n, 1.0);
+    }
+}
+
+// Two-sided higher-criticism bounds sqrt(n)|i/n - X_(i)| <= x*sqrt(X_(i)(1-X_(i))), which are the roots of
+// (p-u)^2 = c*u*(1-u) for p = i/n and c = x^2/n.
+static void higher_criticism_bounds(int n, double x, vector<double>& b, vector<double>& B)
+{
+    double c = x*x / n;
+    b.resize(n);
+    B.resize(n);
+    for (int i = 0; i < n; ++i) {
+        double p = (i+1.0) / n;
+        double root = sqrt((2*p+c)*(2*p+c) - 4*(1+c)*p*p);
+        b[i] = max(0.0, ((2*p+c) - root) / (2*(1+c)));
+        B[i] = min(1.0, ((2*p+c) + root) / (2*(1+c)));
+    }
+}
+
+// Bounds d around a fixed random sample, i.e. a random monotone band. The generator is seeded, so the corpus
+// is the same on all machines.
+static void random_monotone_bounds(int n, double d, vector<double>& b, vector<double>& B)
+{
+    mt19937_64 rng(n);
+    vector<double> u(n);
+    for (int i = 0; i < n; ++i) {
+        u[i] = (rng() >> 11) * (1.0 / 9007199254740992.0);
+    }
+    sort(u.begin(), u.end());
+    b.resize(n);
+    B.resize(n);
+    for (int i = 0; i < n; ++i) {
+        b[i] = max(0.0, u[i] - d);
+        B[i] = min(1.0, u[i] + d);
+    }
+}
+
+struct CorpusCase {
+    string name;
+    int n;
+    function<double()> f;
+    function<double()> reference;  // The same probability by ecdf2_reference(), computed once per bounds.
+};
+
+// Returns a function that computes ecdf2_reference(b, B) on its first call and then returns the same value.
+static function<double()> cached_reference(const vector<double>& b, const vector<double>& B)
+{
+    // Empty until computed. Not a NaN, since isnan() is always false with -ffast-math.
+    shared_ptr<vector<double> > value = make_shared<vector<double> >();
+    return [b, B, value]() {
+        if (value->empty()) {
+            value->push_back(ecdf2_reference(b, B));
+        }
+        return value->front();
+    };
+}
+
+// The fixed corpus of the regression suite. Each shape has a one-sided variant with only the upper bound B,
+// computed by ecdf1-new, and a two-sided variant computed by ecdf2-blocked and auto (and ecdf2-mn2017 for n<=1000).
+// Only the cases whose name contains filter are returned.
+static vector<CorpusCase> corpus_cases(int max_n, const string& filter)
+{
+    vector<CorpusCase> cases;
+    for (int n = 100; n <= max_n; n *= 10) {
+        vector<pair<string, shared_ptr<pair<vector<double>, vector<double> > > > > shapes;
+        vector<double> b, B;
+        get_boundary_family("ks").compute_bounds(n, get_boundary_family("ks").asymptotic_threshold(n, 0.05), b, B);
+        shapes.push_back(make_pair("ks", make_shared<pair<vector<double>, vector<double> > >(b, B)));
+        get_boundary_family("mn").compute_bounds(n, get_boundary_family("mn").asymptotic_threshold(n, 0.05), b, B);
+        shapes.push_back(make_pair("bj", make_shared<pair<vector<double>, vector<double> > >(b, B)));
+        higher_criticism_bounds(n, 3.0, b, B);
+        shapes.push_back(make_pair("hc", make_shared<pair<vector<double>, vector<double> > >(b, B)));
+        random_monotone_bounds(n, 1.5 / sqrt(n), b, B);
+        shapes.push_back(make_pair("random", make_shared<pair<vector<double>, vector<double> > >(b, B)));
+
+        for (unsigned int j = 0; j < shapes.size(); ++j) {
+            const string& shape = shapes[j].first;
+            shared_ptr<pair<vector<double>, vector<double> > > bounds = shapes[j].second;
+            function<double()> one_sided_reference = cached_reference(vector<double>(n, 0.0), bounds->second);
+            function<double()> two_sided_reference = cached_reference(bounds->first, bounds->second);
+            vector<CorpusCase> shape_cases;
+            shape_cases.push_back({shape + "-plus/ecdf1-new", n, [bounds]() { return ecdf1_new_B(bounds->second); }, one_sided_reference});
+            shape_cases.push_back({shape + "/ecdf2-blocked", n, [bounds]() { return ecdf2_blocked(bounds->first, bounds->second); }, two_sided_reference});
+            shape_cases.push_back({shape + "/auto", n, [bounds]() { return ecdf_auto(bounds->first, bounds->second); }, two_sided_reference});
+            if (n <= 1000) {
+                shape_cases.push_back({shape + "/ecdf2-mn2017", n, [bounds]() { return ecdf2(bounds->first, bounds->second, true); }, two_sided_reference});
+            }
+            for (unsigned int k = 0; k < shape_cases.size(); ++k) {
+                if (shape_cases[k].name.find(filter) != string::npos) {
+                    cases.push_back(shape_cases[k]);
+                }
+            }
+        }
+    }
+    return cases;
+}
+
+int run_corpus(const BenchmarkOptions& options)
+{
+    bool first = true;
+    print_header(options);
+    vector<CorpusCase> cases = corpus_cases(options.max_n, options.filter);
+    for (unsigned int k = 0; k < cases.size(); ++k) {
+        double value = 0.0;
+        const function<double()>& f = cases[k].f;
+        BenchmarkResult result = run_benchmark(cases[k].name, cases[k].n, [&]() { value = f(); }, options);
+        result.value = value;
+        if (options.reference) {
+            result.reference = cases[k].reference();
+        }
+        print_result(result, first, options);
+        first = false;
+    }
+    print_footer(options);
+    return 0;
+}
+
+const int STRESS_ROUNDS = 3;
+
+// Runs the corpus (and ecdf1-mns2016 and ecdf2-ks2001, which aren't in it) concurrently on several threads and
+// checks that every result is identical to the single-threaded one. Each thread starts at a different case,
+// so that different algorithms, FFT sizes and plan creations overlap.
+int run_stress(const BenchmarkOptions& options)
+{
+    vector<CorpusCase> cases = corpus_cases(options.max_n, options.filter);
+    for (int n = 100; n <= min(options.max_n, 1000); n *= 10) {
+        vector<double> b, B;
+        const BoundaryFamily& mn_plus = get_boundary_family("mn-plus");
+        mn_plus.compute_bounds(n, mn_plus.asymptotic_threshold(n, 0.05), b, B);
+        string name = "bj-plus/ecdf1-mns2016";
+        if (name.find(options.filter) != string::npos) {
+            cases.push_back({name, n, [b, B]() { return b.empty() ? ecdf1_mns2016_B(B) : ecdf1_mns2016_b(b); }});
+        }
+        const BoundaryFamily& ks = get_boundary_family("ks");
+        ks.compute_bounds(n, ks.asymptotic_threshold(n, 0.05), b, B);
+        name = "ks/ecdf2-ks2001";
+        if ((n == 100) && (name.find(options.filter) != string::npos)) {
+            cases.push_back({name, n, [b, B]() { return ecdf2(b, B, false); }});
+        }
+    }
+
+    vector<double> expected(cases.size());
+    for (unsigned int k = 0; k < cases.size(); ++k) {
+        expected[k] = cases[k].f();
+    }
+
+    atomic<int> num_calls(0);
+    atomic<int> num_mismatches(0);
+    vector<thread> threads;
+    for (int t = 0; t < options.stress_threads; ++t) {
+        threads.push_back(thread([&, t]() {
+            for (unsigned int j = 0; j < STRESS_ROUNDS*cases.size(); ++j) {
+                unsigned int k = (t + j) % cases.size();
+                double value = cases[k].f();
+                ++num_calls;
+                if (!(value == expected[k])) {
+                    ++num_mismatches;
+                    cerr << "Mismatch in " << cases[k].name << " n=" << cases[k].n << ": " << value << " instead of " << expected[k] << endl;
+                }
+            }
+        }));
+    }
+    for (unsigned int t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    cout << "stress: " << options.stress_threads << " threads, " << num_calls << " calls of " << cases.size() << " cases, " << num_mismatches << " mismatches" << endl;
+    return (num_mismatches > 0) ? 1 : 0;
+}
+
+struct ConsistencyCheck {
+    string name;
+    // Returns the largest absolute difference between the results of the checked function and the plain algorithm.
+    function<double()> max_difference;
+    double tolerance;
+};
+
+// Two-sided KS bounds of crossing probability about 0.05 whose windows are above the FFT convolution threshold.
+const int CHECK_N = 3000;
+
+// Resumes from the checkpoints of a computation whose bounds only differ in the last quarter and compares with
+// an uninterrupted run. Returns infinity if nothing was resumed.
+static double checkpoints_difference(bool two_sided)
+{
+    vector<double> b, B;
+    get_boundary_family("ks").compute_bounds(CHECK_N, 0.025, b, B);
+    vector<double> B_tail = B;
+    for (int i = 3*CHECK_N/4; i < CHECK_N; ++i) {
+        B_tail[i] = min(1.0, B[i] + 0.01);
+    }
+    ComputationContext ctx(CHECK_N);
+    NoncrossingCheckpoints checkpoints(CHECK_N / 20);
+    double resumed;
+    double uninterrupted;
+    if (two_sided) {
+        ecdf2(b, B, true, ctx, checkpoints);
+        resumed = ecdf2(b, B_tail, true, ctx, checkpoints);
+        uninterrupted = ecdf2(b, B_tail, true, ctx);
+    } else {
+        ecdf1_new_B(B, ctx, checkpoints);
+        resumed = ecdf1_new_B(B_tail, ctx, checkpoints);
+        uninterrupted = ecdf1_new_B(B_tail, ctx);
+    }
+    if (checkpoints.get_resumed_step() == 0) {
+        return numeric_limits<double>::infinity();
+    }
+    return fabs(resumed - uninterrupted);
+}
+
+// ecdf2_all_sample_sizes() against ecdf2() of the first m bounds, for several m.
+static double all_sample_sizes_difference()
+{
+    vector<double> b, B;
+    get_boundary_family("ks").compute_bounds(CHECK_N, 0.025, b, B);
+    vector<double> probs = ecdf2_all_sample_sizes(b, B, true);
+    double difference = 0.0;
+    for (int m : {1, 10, 100, 500, 1000, 2000, 2999, CHECK_N}) {
+        vector<double> b_prefix(b.begin(), b.begin()+m);
+        vector<double> B_prefix(B.begin(), B.begin()+m);
+        difference = max(difference, fabs(probs[m] - ecdf2(b_prefix, B_prefix, true)));
+    }
+    return difference;
+}
+
+// ecdf2_prefix_noncrossing_probabilities() against ecdf2() of the bounds cut at each time t.
+static double prefix_difference()
+{
+    vector<double> b, B;
+    get_boundary_family("ks").compute_bounds(CHECK_N, 0.025, b, B);
+    vector<double> t = {0.0, 0.1, 0.25, 0.5, 0.9, 1.0};
+    vector<double> probs = ecdf2_prefix_noncrossing_probabilities(b, B, true, t);
+    double difference = 0.0;
+    for (unsigned int j = 0; j < t.size(); ++j) {
+        vector<double> b_cut(CHECK_N), B_cut(CHECK_N);
+        for (int i = 0; i < CHECK_N; ++i) {
+            b_cut[i] = min(b[i], t[j]);
+            B_cut[i] = (B[i] <= t[j]) ? B[i] : 1.0;
+        }
+        difference = max(difference, fabs(probs[j] - ecdf2(b_cut, B_cut, true)));
+    }
+    return difference;
+}
+
+// FFTWConvolver::convolve_many() against convolve_same_size() of each column, with the given FFT backend. The sizes
+// mix naive columns, several columns of the same FFT size and single ones, in a shuffled order. Covers a shared
+// kernel, a kernel per column, and outputs that are the inputs.
+static double convolve_many_difference(const string& backend)
+{
+    const vector<int> sizes = {200, 50, 1100, 130, 127, 700, 200, 300, 1, 1500, 500, 130};
+    int max_size = *max_element(sizes.begin(), sizes.end());
+    int num_columns = sizes.size();
+    mt19937_64 rng(num_columns);
+    auto random_column = [&](int size) {
+        vector<double> column(size);
+        for (int i = 0; i < size; ++i) {
+            column[i] = (rng() >> 11) * (1.0 / 9007199254740992.0) / size;
+        }
+        return column;
+    };
+    vector<double> shared_kernel = random_column(max_size);
+    vector<vector<double> > kernels, inputs;
+    for (int size : sizes) {
+        kernels.push_back(random_column(size));
+        inputs.push_back(random_column(size));
+    }
+
+    string selected_backend = get_fft_backend();
+    set_fft_backend(backend);
+    FFTWConvolver fftconvolver(max_size);
+    set_fft_backend(selected_backend);
+    double difference = 0.0;
+    for (int variant = 0; variant < 3; ++variant) {
+        bool per_column_kernels = (variant == 1);
+        bool in_place = (variant == 2);
+        vector<vector<double> > columns = inputs;
+        vector<vector<double> > outputs(num_columns);
+        vector<const double*> kernel_pointers(num_columns);
+        vector<const double*> input_pointers(num_columns);
+        vector<double*> output_pointers(num_columns);
+        for (int j = 0; j < num_columns; ++j) {
+            outputs[j].assign(sizes[j], 0.0);
+            kernel_pointers[j] = per_column_kernels ? kernels[j].data() : shared_kernel.data();
+            input_pointers[j] = columns[j].data();
+            output_pointers[j] = in_place ? columns[j].data() : outputs[j].data();
+        }
+        if (per_column_kernels) {
+            fftconvolver.convolve_many(num_columns, sizes.data(), kernel_pointers.data(), input_pointers.data(), output_pointers.data());
+        } else {
+            fftconvolver.convolve_many(num_columns, sizes.data(), shared_kernel.data(), input_pointers.data(), output_pointers.data());
+        }
+        vector<double> expected(max_size);
+        for (int j = 0; j < num_columns; ++j) {
+            fftconvolver.convolve_same_size(sizes[j], kernel_pointers[j], inputs[j].data(), expected.data());
+            for (int i = 0; i < sizes[j]; ++i) {
+                difference = max(difference, fabs(output_pointers[j][i] - expected[i]));
+            }
+        }
+    }
+    return difference;
+}
+
+static vector<ConsistencyCheck> consistency_checks()
+{
+    vector<ConsistencyCheck> checks;
+    // The resumed computation goes through the same operations as the uninterrupted one.
+    checks.push_back({"checkpoints/ecdf2-mn2017", []() { return checkpoints_difference(true); }, 0.0});
+    checks.push_back({"checkpoints/ecdf1-new", []() { return checkpoints_difference(false); }, 0.0});
+    // The sweeps of other Poisson intensities and the query steps change the round-off errors.
+    checks.push_back({"ecdf2_all_sample_sizes", all_sample_sizes_difference, 1e-10});
+    checks.push_back({"ecdf2_prefix_noncrossing_probabilities", prefix_difference, 1e-12});
+    for (const string& backend : available_fft_backends()) {
+        checks.push_back({"convolve_many/" + backend, [backend]() { return convolve_many_difference(backend); }, 1e-15});
+    }
+    return checks;
+}
+
+int run_checks(const BenchmarkOptions& options)
+{
+    int num_checks = 0;
+    int num_failures = 0;
+    vector<ConsistencyCheck> checks = consistency_checks();
+    for (unsigned int k = 0; k < checks.size(); ++k) {
+        if (checks[k].name.find(options.filter) == string::npos) {
+            continue;
+        }
+        double difference = checks[k].max_difference();
+        bool ok = difference <= checks[k].tolerance;
+        ++num_checks;
+        num_failures += ok ? 0 : 1;
+        cout << checks[k].name << " max_difference " << difference << " tolerance " << checks[k].tolerance << (ok ? " ok" : " FAILED") << endl;
+    }
+    cout << "check: " << num_checks << " checks, " << num_failures << " failures" << endl;
+    return (num_failures > 0) ? 1 : 0;
+}
+
+int run_benchmarks(const BenchmarkOptions& options)
+{
+    bool first = true;
+    auto bench = [&](const string& name, int size, const function<void()>& f) {
+        if (name.find(options.filter) == string::npos) {
+            return;
+        }
+        print_result(run_benchmark(name, size, f, options), first, options);
+        first = false;
+    };
+
+    print_header(options);
+
+    int max_size = 16*options.max_n;
+    FFTWConvolver fftconvolver(max_size);
+    // One convolver per FFT backend, the others use the selected one.
+    vector<string> backends = available_fft_backends();
+    string selected_backend = get_fft_backend();
+    vector<unique_ptr<FFTWConvolver> > backend_convolvers;
+    for (const string& backend : backends) {
+        set_fft_backend(backend);
+        backend_convolvers.push_back(unique_ptr<FFTWConvolver>(new FFTWConvolver(max_size)));
+    }
+    set_fft_backend(selected_backend);
+    PoissonPMFGenerator pmfgen(max_size);
+    vector<double> src0(max_size, 1.0 / max_size);
+    vector<double> src1(max_size, 1.0 / max_size);
+    vector<double> dest(max_size, 0.0);
+    for (int size : kernel_sizes(max_size)) {
+        bench("fftwconvolver", size, [&]() { fftconvolver.convolve_same_size(size, &src0[0], &src1[0], &dest[0]); });
+        for (unsigned int j = 0; j < backends.size(); ++j) {
+            bench("convolver_" + backends[j], size, [&]() { backend_convolvers[j]->convolve_same_size(size, &src0[0], &src1[0], &dest[0]); });
+        }
+        if (size <= 4096) {
+            bench("convolve_same_size", size, [&]() { convolve_same_size(size, &src0[0], &src1[0], &dest[0]); });
+            bench("convolve_same_size_naive", size, [&]() { convolve_same_size_naive(size, &src0[0], &src1[0], &dest[0]); });
+        }
+        if (8*size <= max_size) {
+            // 8 columns of the given size, batched by FFTWConvolver::convolve_many(), with 8 kernels or a shared one.
+            vector<int> sizes(8, size);
+            vector<const double*> kernels, inputs;
+            vector<double*> outputs;
+            for (int c = 0; c < 8; ++c) {
+                kernels.push_back(&src0[c*size]);
+                inputs.push_back(&src1[c*size]);
+                outputs.push_back(&dest[c*size]);
+            }
+            bench("convolve_many_8", size, [&]() { fftconvolver.convolve_many(8, &sizes[0], &kernels[0], &inputs[0], &outputs[0]); });
+            bench("convolve_many_8_shared", size, [&]() { fftconvolver.convolve_many(8, &sizes[0], &src0[0], &inputs[0], &outputs[0]); });
+        }
+        bench("compute_array", size, [&]() { pmfgen.compute_array(size, 0.5*size); });
+        bench("subtract_scaled_pmf", size, [&]() { pmfgen.subtract_scaled_pmf(1e-3, 0.5*size, 1, size-1, &dest[0]); });
+    }
+
+    for (int degree : kernel_sizes(min(max_size, 4096))) {
+        PolynomialTranslatedMonomials p(degree);
+        for (int i = 0; i < degree; ++i) {
+            p.integrate();
+            p.set_additive_coefficient(1, -double(i) / degree);
+        }
+        for (int i = 0; i <= degree; ++i) {
+            p.set_multiplicative_coefficient(i, 1.0 / (i+1));
+        }
+        bench("polynomial_evaluate", degree, [&]() { p.evaluate(0.5); });
+    }
+
+    const BoundaryFamily& ks_plus = get_boundary_family("ks-plus");
+    const BoundaryFamily& ks = get_boundary_family("ks");
+    for (int n : algorithm_sizes(options.max_n)) {
+        vector<double> b1, B1, b2, B2;
+        ks_plus.compute_bounds(n, ks_plus.asymptotic_threshold(n, 0.05), b1, B1);
+        ks.compute_bounds(n, ks.asymptotic_threshold(n, 0.05), b2, B2);
+        bool lower = !b1.empty();
+        complete_bounds(n, b1, B1);
+        complete_bounds(n, b2, B2);
+
+        if (n <= 3000) {
+            bench("ecdf1-mns2016", n, [&]() { lower ? ecdf1_mns2016_b(b1) : ecdf1_mns2016_B(B1); });
+            bench("ecdf2-ks2001", n, [&]() { ecdf2(b2, B2, false); });
+        }
+        bench("ecdf1-new", n, [&]() { lower ? ecdf1_new_b(b1) : ecdf1_new_B(B1); });
+        bench("ecdf2-mn2017", n, [&]() { ecdf2(b2, B2, true); });
+        bench("ecdf2-blocked", n, [&]() { ecdf2_blocked(b2, B2); });
+        bench("auto", n, [&]() { ecdf_auto(b2, B2); });
+    }
+
+    print_footer(options);
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options = {false, false, "csv", "", 10000, 0.1, 5, 0, false};
+    const string FORMAT_OPTION = "--format=";
+    const string FILTER_OPTION = "--filter=";
+    const string MAX_N_OPTION = "--max-n=";
+    const string MIN_TIME_OPTION = "--min-time=";
+    const string MIN_SAMPLES_OPTION = "--min-samples=";
+    const string STRESS_OPTION = "--stress=";
+    const string FFT_OPTION = "--fft=";
+    try {
+        for (int i = 1; i < argc; ++i) {
+            string arg = string(argv[i]);
+            if (arg == "--help") {
+                print_usage();
+                return 0;
+            } else if (arg == "--corpus") {
+                options.corpus = true;
+            } else if (arg == "--check") {
+                options.check = true;
+            } else if (arg == "--reference") {
+                options.reference = true;
+            } else if (arg.compare(0, FORMAT_OPTION.size(), FORMAT_OPTION) == 0) {
+                options.format = arg.substr(FORMAT_OPTION.size());
+            } else if (arg.compare(0, FILTER_OPTION.size(), FILTER_OPTION) == 0) {
+                options.filter = arg.substr(FILTER_OPTION.size());
+            } else if (arg.compare(0, MAX_N_OPTION.size(), MAX_N_OPTION) == 0) {
+                options.max_n = string_to_long(arg.substr(MAX_N_OPTION.size()));
+            } else if (arg.compare(0, MIN_TIME_OPTION.size(), MIN_TIME_OPTION) == 0) {
+                options.min_seconds = string_to_double(arg.substr(MIN_TIME_OPTION.size()));
+            } else if (arg.compare(0, MIN_SAMPLES_OPTION.size(), MIN_SAMPLES_OPTION) == 0) {
+                options.min_samples = string_to_long(arg.substr(MIN_SAMPLES_OPTION.size()));
+                if ((options.min_samples <= 0) || (options.min_samples > MAXIMUM_CORPUS_SAMPLES)) {
+                    throw runtime_error("Expecting --min-samples=<k> with 0 < k <= 200");
+                }
+            } else if (arg.compare(0, FFT_OPTION.size(), FFT_OPTION) == 0) {
+                set_fft_backend(arg.substr(FFT_OPTION.size()));
+            } else if (arg.compare(0, STRESS_OPTION.size(), STRESS_OPTION) == 0) {
+                options.stress_threads = string_to_long(arg.substr(STRESS_OPTION.size()));
+                if (options.stress_threads <= 0) {
+                    throw runtime_error("Expecting a positive number of threads in --stress=<threads>");
+                }
+            } else {
+                print_usage();
+                throw runtime_error("Unknown argument '" + arg + "'");
+            }
+        }
+        if (options.reference && !options.corpus) {
+            throw runtime_error("--reference is only used with --corpus");
+        }
+        if ((options.format != "csv") && (options.format != "json")) {
+            throw runtime_error("Expecting --format=csv or --format=json");
+        }
+        if (options.max_n < 10) {
+            throw runtime_error("Expecting --max-n of at least 10");
+        }
+        if (options.stress_threads > 0) {
+            return run_stress(options);
+        }
+        if (options.check) {
+            return run_checks(options);
+        }
+        return options.corpus ? run_corpus(options) : run_benchmarks(options);
+    } catch (runtime_error& e) {
+        cout << "Error:" << endl;
+        cout << e.what() << endl;
+        return 3;
+    }
+}
@@ -159,13 +159,13 @@ static double poisson_process_crossing_probability_montecarlo(double intensity,
 static void print_usage()
 {
     cout << "SYNOPSIS\n";
-    cout << "    crossing_probability poisson <boundary-functions-file> <num-simulations>\n";
+    cout << "    crossing_probability poisson [<intensity>] <boundary-functions-file> <num-simulations>\n";
     cout << "    crossing_probability ecdf <boundary-functions-file> <num-simulations>\n";
     cout << endl;
     cout << "DESCRIPTION\n";
-    cout << "    crossing_probability poisson <boundary-functions-file> <num-simulations>\n";
+    cout << "    crossing_probability poisson [<intensity>] <boundary-functions-file> <num-simulations>\n";
     cout << "        Estimates (using Monte-Carlo simulations) the non-crossing probability that that g(t) < xi_n(t) < h(t) for all t in [0,1]\n";
-    cout << "        where xi_n(t) is a homogeneous Poisson process of intensity n in the interval [0,1].\n";
+    cout << "        where xi_n(t) is a homogeneous Poisson process of the given intensity (n by default) in the interval [0,1].\n";
     cout << endl;
     cout << "    crossing_probability ecdf <boundary-functions-file> <num-simulations>\n";
     cout << "        Estimates (using Monte-Carlo simulations) the non-crossing probability that that g(t) < F_n(t) < h(t) for all t in [0,1]\n";
@@ -191,15 +191,17 @@ static void print_usage()
 
 static int handle_command_line_arguments(int argc, char* argv[])
 {
-    if (argc != 4) {
+    if ((argc != 4) && !((argc == 5) && (string(argv[1]) == "poisson"))) {
         print_usage();
         throw runtime_error("Expecting 3 command line arguments!");
     }
 
     string command = string(argv[1]);
 
-    string filename = string(argv[2]);
-    long num_simulations = string_to_long(argv[3]);
+    // The optional intensity of the poisson command comes before the filename.
+    int arg = (argc == 5) ? 3 : 2;
+    string filename = string(argv[arg]);
+    long num_simulations = string_to_long(argv[arg+1]);
     if (num_simulations < 0) {
         print_usage();
         throw runtime_error("num-simulations must be non-negative!");
@@ -211,8 +213,9 @@ static int handle_command_line_arguments(int argc, char* argv[])
     int n = max(b.size(), B.size());
 
     if (command == "poisson") {
+        double intensity = (argc == 5) ? string_to_double(argv[2]) : n;
         // cout << "Running " << num_simulations << " simulations...\n";
-        double crossprob = poisson_process_crossing_probability_montecarlo(n, b, B, num_simulations);
+        double crossprob = poisson_process_crossing_probability_montecarlo(intensity, b, B, num_simulations);
         cout << 1.0-crossprob << endl;
     } else if (command == "ecdf") {
         // cout << "Running " << num_simulations << " simulations...\n";
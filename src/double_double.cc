@@ -0,0 +1,464 @@
+// The error-free transformations below need every operation to be rounded exactly as written, so this file is compiled
+// without the -ffast-math of the Makefile and setup.py. The pragma must come before the includes, so that the inline
+// functions and templates instantiated here (std::complex, BasicRealFFT) get the same options.
+#if defined(__clang__)
+#pragma float_control(precise, on)
+#elif defined(__GNUC__)
+#pragma GCC optimize ("no-fast-math")
+#endif
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <cmath>
+#include <cassert>
+#include <algorithm>
+#include <stdexcept>
+
+#include "double_double.hh"
+#include "common.hh"
+#include "sorted_bounds.hh"
+#include "builtin_fft.hh"
+
+using namespace std;
+
+// a + b = s + e exactly.
+static inline double two_sum(double a, double b, double& e)
+{
+    double s = a + b;
+    double v = s - a;
+    e = (a - (s - v)) + (b - v);
+    return s;
+}
+
+// Same, assuming |a| >= |b|.
+static inline double quick_two_sum(double a, double b, double& e)
+{
+    double s = a + b;
+    e = b - (s - a);
+    return s;
+}
+
+// The arithmetic of the QD library, see Hida, Li and Bailey (2001), Algorithms for quad-double precision floating point
+// arithmetic.
+struct DoubleDouble {
+    double hi;
+    double lo;
+
+    DoubleDouble() : hi(0.0), lo(0.0) {}
+    DoubleDouble(double x) : hi(x), lo(0.0) {}
+    DoubleDouble(double hi, double lo) : hi(hi), lo(lo) {}
+};
+
+typedef DoubleDouble DD;
+
+static inline DD operator+(const DD& a, const DD& b)
+{
+    double e1, e2;
+    double s = two_sum(a.hi, b.hi, e1);
+    double t = two_sum(a.lo, b.lo, e2);
+    e1 += t;
+    s = quick_two_sum(s, e1, e1);
+    e1 += e2;
+    s = quick_two_sum(s, e1, e1);
+    return DD(s, e1);
+}
+
+static inline DD operator-(const DD& a)
+{
+    return DD(-a.hi, -a.lo);
+}
+
+static inline DD operator-(const DD& a, const DD& b)
+{
+    return a + (-b);
+}
+
+static inline DD operator*(const DD& a, const DD& b)
+{
+    double p = a.hi * b.hi;
+    double e = fma(a.hi, b.hi, -p) + (a.hi*b.lo + a.lo*b.hi);
+    p = quick_two_sum(p, e, e);
+    return DD(p, e);
+}
+
+static inline DD operator*(const DD& a, double b)
+{
+    double p = a.hi * b;
+    double e = fma(a.hi, b, -p) + a.lo*b;
+    p = quick_two_sum(p, e, e);
+    return DD(p, e);
+}
+
+static inline DD operator/(const DD& a, double b)
+{
+    double q1 = a.hi / b;
+    DD r = a - DD(q1)*b;
+    double q2 = r.hi / b;
+    r = r - DD(q2)*b;
+    double q3 = r.hi / b;
+    double e;
+    q1 = quick_two_sum(q1, q2, e);
+    return DD(q1, e) + q3;
+}
+
+static inline DD operator/(const DD& a, const DD& b)
+{
+    double q1 = a.hi / b.hi;
+    DD r = a - b*q1;
+    double q2 = r.hi / b.hi;
+    r = r - b*q2;
+    double q3 = r.hi / b.hi;
+    double e;
+    q1 = quick_two_sum(q1, q2, e);
+    return DD(q1, e) + q3;
+}
+
+static inline DD& operator+=(DD& a, const DD& b) { a = a + b; return a; }
+static inline DD& operator-=(DD& a, const DD& b) { a = a - b; return a; }
+static inline DD& operator*=(DD& a, const DD& b) { a = a * b; return a; }
+
+static inline DD ldexp(const DD& a, int exponent)
+{
+    return DD(ldexp(a.hi, exponent), ldexp(a.lo, exponent));
+}
+
+const DD LN2(0.6931471805599453, 2.3190468138462996e-17);
+const DD PI(3.141592653589793, 1.2246467991473532e-16);
+
+// Below this, exp() is subnormal.
+const double LOG_UNDERFLOW = -708.0;
+
+// exp(a) for a < 709. As in the QD library, a = m*log(2) + 512*r, exp(r)-1 is summed by its Taylor series, squared
+// nine times by (1+s)^2 - 1 = 2s + s^2 without losing its low bits, and scaled by 2^m.
+static DD exp_dd(const DD& a)
+{
+    if (a.hi < LOG_UNDERFLOW) {
+        return DD(0.0);
+    }
+    double m = floor(a.hi / LN2.hi + 0.5);
+    DD r = ldexp(a - LN2*m, -9);
+    // |r| < 7e-4, so the terms after r^10/10! are below 1e-35 relative to r.
+    DD power = r*r;
+    DD s = r + ldexp(power, -1);
+    double factorial = 2.0;
+    for (int i = 3; i <= 10; ++i) {
+        power *= r;
+        factorial *= i;
+        s += power / factorial;
+    }
+    for (int i = 0; i < 9; ++i) {
+        s = ldexp(s, 1) + s*s;
+    }
+    return ldexp(s + DD(1.0), int(m));
+}
+
+// log(a) for a > 0, by a Newton step x + a*exp(-x) - 1 from the double precision logarithm x, which doubles its bits.
+static DD log_dd(const DD& a)
+{
+    assert(a.hi > 0.0);
+    DD x(log(a.hi));
+    return x + a*exp_dd(-x) - DD(1.0);
+}
+
+// The Bernoulli numbers B_2, B_4, ..., B_24.
+const int STIRLING_TERMS = 12;
+const double BERNOULLI_NUMERATORS[STIRLING_TERMS] = {1, -1, 1, -1, 5, -691, 7, -3617, 43867, -174611, 854513, -236364091};
+const double BERNOULLI_DENOMINATORS[STIRLING_TERMS] = {6, 30, 42, 30, 66, 2730, 6, 510, 798, 330, 138, 2730};
+
+// From this on the Stirling series with STIRLING_TERMS terms is accurate to 1e-36.
+const int MINIMUM_STIRLING_ARGUMENT = 50;
+
+// log(Pr[Pois(lambda) = k]) for lambda > 0.
+static DD log_poisson_pmf_dd(const DD& lambda, int k)
+{
+    assert(k >= 0);
+    if (k < MINIMUM_STIRLING_ARGUMENT) {
+        DD factorial(1.0);
+        for (int i = 2; i <= k; ++i) {
+            factorial = factorial*double(i);
+        }
+        return log_dd(lambda)*double(k) - lambda - log_dd(factorial);
+    }
+    // The terms of -lambda + k*log(lambda) - log(k!) are much larger than their sum near the mode, and their round-off
+    // would be amplified by the cancellation, as in poisson_pmf_relative_error(). By the Stirling series
+    //     log(k!) = (k+1/2)log(k) - k + log(2 pi)/2 + sum_j B_2j / (2j(2j-1)k^(2j-1)),
+    // the log-PMF is k*log(lambda/k) + (k - lambda) - log(2 pi k)/2 - sum_j ..., where the first two terms are small.
+    double x = k;
+    DD inverse_x = DD(1.0) / x;
+    DD inverse_x2 = inverse_x*inverse_x;
+    DD series(0.0);
+    for (int j = STIRLING_TERMS; j >= 1; --j) {
+        series = series*inverse_x2 + DD(BERNOULLI_NUMERATORS[j-1]) / (BERNOULLI_DENOMINATORS[j-1]*(2*j)*(2*j-1));
+    }
+    return log_dd(lambda / x)*x + (DD(x) - lambda) - ldexp(log_dd(PI*(2*x)), -1) - series*inverse_x;
+}
+
+// Pr[Pois(lambda) = k].
+static DD poisson_pmf_dd(const DD& lambda, int k)
+{
+    assert(k >= 0);
+    if (lambda.hi == 0.0) {
+        return DD((k == 0) ? 1.0 : 0.0);
+    }
+    return exp_dd(log_poisson_pmf_dd(lambda, k));
+}
+
+// sin(x) and cos(x) for 0 <= x <= pi/4 by their Taylor series.
+static void sin_cos_dd(const DD& x, DD& sin_x, DD& cos_x)
+{
+    DD minus_x2 = -(x*x);
+    DD term = x;
+    sin_x = x;
+    for (int i = 2; fabs(term.hi) > 1e-40; i += 2) {
+        term = term*minus_x2 / (double(i)*(i+1));
+        sin_x += term;
+    }
+    term = DD(1.0);
+    cos_x = DD(1.0);
+    for (int i = 1; fabs(term.hi) > 1e-40; i += 2) {
+        term = term*minus_x2 / (double(i)*(i+1));
+        cos_x += term;
+    }
+}
+
+template <>
+struct FFTUnitRoot<DD> {
+    static complex<DD> get(int j, int n)
+    {
+        // The angle 2 pi j/n is reduced to [0, pi/4] by the symmetries of sin and cos. n is a power of 2, so the
+        // fractions of a turn are exact.
+        double turns = double(j) / n;
+        int quadrant = int(4*turns);
+        double reduced = turns - 0.25*quadrant;
+        DD c, s;
+        if (reduced <= 0.125) {
+            sin_cos_dd(PI*(2*reduced), s, c);
+        } else {
+            sin_cos_dd(PI*(2*(0.25 - reduced)), c, s);
+        }
+        for (int q = 0; q < quadrant; ++q) {
+            // A quarter turn: (cos, sin) -> (-sin, cos).
+            DD rotated_cos = -s;
+            s = c;
+            c = rotated_cos;
+        }
+        return complex<DD>(c, -s);
+    }
+};
+
+// The size of the array without its trailing zeros.
+static int support_size(int size, const double* hi, const double* lo)
+{
+    while ((size > 0) && (hi[size-1] == 0.0) && (lo[size-1] == 0.0)) {
+        --size;
+    }
+    return size;
+}
+
+// convolve_same_size_dd() into sum_hi and sum_lo, which have at least size entries and must not overlap the sources.
+static void convolve_into_sums_dd(int size, const double* src0_hi, const double* src0_lo, const double* src1_hi, const double* src1_lo, double* sum_hi, double* sum_lo)
+{
+    // The outer loop is over src0 and the inner one over the outputs, so that the inner loop has no dependencies
+    // between its iterations and vectorizes without reordering the additions.
+    fill(sum_hi, sum_hi+size, 0.0);
+    fill(sum_lo, sum_lo+size, 0.0);
+    int support = support_size(size, src0_hi, src0_lo);
+    for (int j = 0; j < support; ++j) {
+        const double a_hi = src0_hi[j];
+        const double a_lo = src0_lo[j];
+        if ((a_hi == 0.0) && (a_lo == 0.0)) {
+            continue;
+        }
+        const double* __restrict__ b_hi = src1_hi;
+        const double* __restrict__ b_lo = src1_lo;
+        double* __restrict__ s_hi = &sum_hi[j];
+        double* __restrict__ s_lo = &sum_lo[j];
+        for (int k = 0; k < size-j; ++k) {
+            // The product a*b, then its sum with s, where the low parts are added without compensation (the "sloppy"
+            // addition of the QD library). This loses accuracy only by cancellation, and the terms are non-negative.
+            double p = a_hi * b_hi[k];
+            double p_error = fma(a_hi, b_hi[k], -p) + (a_hi*b_lo[k] + a_lo*b_hi[k]);
+            double s = s_hi[k] + p;
+            double v = s - s_hi[k];
+            double e = (s_hi[k] - (s - v)) + (p - v);
+            e += s_lo[k] + p_error;
+            double t = s + e;
+            s_lo[k] = e - (t - s);
+            s_hi[k] = t;
+        }
+    }
+}
+
+void convolve_same_size_dd(int size, const double* src0_hi, const double* src0_lo, const double* src1_hi, const double* src1_lo, double* dest_hi, double* dest_lo)
+{
+    vector<double> sum_hi(size);
+    vector<double> sum_lo(size);
+    convolve_into_sums_dd(size, src0_hi, src0_lo, src1_hi, src1_lo, sum_hi.data(), sum_lo.data());
+    copy(sum_hi.begin(), sum_hi.end(), dest_hi);
+    copy(sum_lo.begin(), sum_lo.end(), dest_lo);
+}
+
+PoissonPMFGeneratorDD::PoissonPMFGeneratorDD(int max_k) : max_k(max_k), pmf_hi(max_k+1, 0.0), pmf_lo(max_k+1, 0.0)
+{
+    assert(max_k >= 0);
+}
+
+void PoissonPMFGeneratorDD::compute_array(int k, double lambda_hi, double lambda_lo)
+{
+    assert(k >= 0);
+    assert(k <= max_k);
+    if (lambda_hi < 0) {
+        throw runtime_error("Expecting lambda>0 in PoissonPMFGeneratorDD::compute_array()");
+    }
+    DD lambda(lambda_hi, lambda_lo);
+    int mode = min(k, int(lambda_hi));
+    DD pmf = poisson_pmf_dd(lambda, mode);
+    pmf_hi[mode] = pmf.hi;
+    pmf_lo[mode] = pmf.lo;
+    int i = mode+1;
+    for (; (i <= k) && (pmf.hi != 0.0); ++i) {
+        pmf = pmf*lambda / double(i);
+        pmf_hi[i] = pmf.hi;
+        pmf_lo[i] = pmf.lo;
+    }
+    // The rest of the tail underflows.
+    fill(pmf_hi.begin()+i, pmf_hi.begin()+k+1, 0.0);
+    fill(pmf_lo.begin()+i, pmf_lo.begin()+k+1, 0.0);
+    if (mode > 0) {
+        DD inverse_lambda = DD(1.0) / lambda;
+        pmf = DD(pmf_hi[mode], pmf_lo[mode]);
+        for (int j = mode-1; j >= 0; --j) {
+            pmf = pmf*inverse_lambda*double(j+1);
+            pmf_hi[j] = pmf.hi;
+            pmf_lo[j] = pmf.lo;
+        }
+    }
+}
+
+// Below this size the convolutions are direct, as in FFTWConvolver.
+const int MINIMUM_SIZE_FOR_FFT_CONVOLUTION = 128;
+
+// The direct convolutions skip the zeros at the end of src0, so they are also used when src0 has fewer non-zero entries
+// than this, whatever the size. The Poisson PMFs of the sweep underflow after a few hundred entries unless lambda is
+// large, and the FFT convolution with BasicRealFFT<DD> is only faster from about this many entries on.
+const int MINIMUM_SUPPORT_FOR_FFT_CONVOLUTION = 1024;
+
+class ConvolverDD {
+public:
+    // dest[k] = sum_{j<=k} src0[j]*src1[k-j] for k=0,...,size-1. dest may be src1.
+    void convolve_same_size(int size, const double* src0_hi, const double* src0_lo, const double* src1_hi, const double* src1_lo, double* dest_hi, double* dest_lo)
+    {
+        if ((size < MINIMUM_SIZE_FOR_FFT_CONVOLUTION) || (support_size(size, src0_hi, src0_lo) < MINIMUM_SUPPORT_FOR_FFT_CONVOLUTION)) {
+            // Through sum_hi and sum_lo, since dest may be src1.
+            if ((int)sum_hi.size() < size) {
+                sum_hi.resize(size);
+                sum_lo.resize(size);
+            }
+            convolve_into_sums_dd(size, src0_hi, src0_lo, src1_hi, src1_lo, sum_hi.data(), sum_lo.data());
+            copy(sum_hi.begin(), sum_hi.begin()+size, dest_hi);
+            copy(sum_lo.begin(), sum_lo.begin()+size, dest_lo);
+            return;
+        }
+
+        int padded_size = 1;
+        while (padded_size < 2*size) {
+            padded_size *= 2;
+        }
+        BasicRealFFT<DD>& fft = get_fft(padded_size);
+        fft_a.resize(padded_size/2 + 1);
+        fft_b.resize(padded_size/2 + 1);
+        tmp.assign(padded_size, DD(0.0));
+        for (int k = 0; k < size; ++k) {
+            tmp[k] = DD(src0_hi[k], src0_lo[k]);
+        }
+        fft.forward(tmp.data(), fft_a.data());
+        for (int k = 0; k < size; ++k) {
+            tmp[k] = DD(src1_hi[k], src1_lo[k]);
+        }
+        fft.forward(tmp.data(), fft_b.data());
+        for (int k = 0; k <= padded_size/2; ++k) {
+            fft_b[k] *= fft_a[k];
+        }
+        fft.backward(fft_b.data(), tmp.data());
+        // padded_size is a power of 2, so its inverse is exact.
+        double normalization = 1.0 / padded_size;
+        for (int k = 0; k < size; ++k) {
+            DD x = tmp[k]*normalization;
+            dest_hi[k] = x.hi;
+            dest_lo[k] = x.lo;
+        }
+    }
+
+private:
+    // The sums of the direct convolutions, grown to the largest size.
+    vector<double> sum_hi;
+    vector<double> sum_lo;
+    map<int, unique_ptr<BasicRealFFT<DD> > > ffts;
+    vector<complex<DD> > fft_a;
+    vector<complex<DD> > fft_b;
+    vector<DD> tmp;
+
+    BasicRealFFT<DD>& get_fft(int size)
+    {
+        unique_ptr<BasicRealFFT<DD> >& fft = ffts[size];
+        if (!fft) {
+            fft.reset(new BasicRealFFT<DD>(size));
+        }
+        return *fft;
+    }
+};
+
+// The sweep of poisson_process_noncrossing_probability() in ecdf2.cc with intensity n, in double-double.
+static DD ecdf2_double_double(const vector<double>& b, const vector<double>& B)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+
+    SortedBounds bounds;
+    join_all_bounds(b, B, vector<double>(), bounds);
+
+    vector<double> state_hi(n+1, 0.0);
+    vector<double> state_lo(n+1, 0.0);
+    state_hi[0] = 1.0;
+    PoissonPMFGeneratorDD pmfgen(n);
+    ConvolverDD convolver;
+
+    int b_step_count = 0;
+    int B_step_count = 0;
+    double prev_location = 0.0;
+    for (unsigned int i = 0; i < bounds.size(); ++i) {
+        int cur_size = b_step_count - B_step_count + 1;
+        // The difference of two doubles is exact as a double-double.
+        double difference_lo;
+        double difference_hi = two_sum(bounds.locations[i], -prev_location, difference_lo);
+        DD lambda = DD(difference_hi, difference_lo)*double(n);
+        if (lambda.hi > 0) {
+            pmfgen.compute_array(cur_size-1, lambda.hi, lambda.lo);
+            convolver.convolve_same_size(cur_size, pmfgen.get_array_hi(), pmfgen.get_array_lo(),
+                &state_hi[B_step_count], &state_lo[B_step_count], &state_hi[B_step_count], &state_lo[B_step_count]);
+        }
+        if (bounds.tags[i] == bSTEP) {
+            ++b_step_count;
+            state_hi[b_step_count] = 0.0;
+            state_lo[b_step_count] = 0.0;
+        } else if (bounds.tags[i] == BSTEP) {
+            state_hi[B_step_count] = 0.0;
+            state_lo[B_step_count] = 0.0;
+            ++B_step_count;
+        }
+        prev_location = bounds.locations[i];
+    }
+    return DD(state_hi[n], state_lo[n]) / poisson_pmf_dd(DD(n), n);
+}
+
+DoubleDoubleProbability ecdf2_dd(const vector<double>& b, const vector<double>& B)
+{
+    DD p = ecdf2_double_double(b, B);
+    DoubleDoubleProbability result;
+    result.noncrossing_probability = p.hi;
+    // The round-off of a non-crossing probability within about 1e-30 of 1 may exceed 1.
+    result.crossing_probability = max(0.0, (DD(1.0) - p).hi);
+    return result;
+}
@@ -2,178 +2,14 @@
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
-#include <cstring>
 #include <cassert>
-#include "mm_malloc.h"
 
 #include "ecdf1_mns2016.hh"
 #include "common.hh"
+#include "polynomial_translated_monomials.hh"
 
 using namespace std;
 
-#define FLOAT_PRECISION_BITS 80
-
-#if FLOAT_PRECISION_BITS == 128
-#include "string_utils.hh"
-    extern "C" {
-        #include <quadmath.h> // Supported in GCC but not clang
-    }
-    typedef __float128 FLOAT;
-    #define EXP expq
-    #define LOG logq
-    #define GAMMA tgammaq
-    #define LOG_GAMMA lgammaq
-    #define POW powq
-    #define FREXP frexpq
-    #define LDEXP ldexpq
-    #define MAX_EXP FLT128_MAX_EXP
-    #define TO_STRING float128_to_string
-    string float128_to_string(__float128 x)
-    {
-        static char s[1000];
-        quadmath_snprintf(s, sizeof(s), "%.30Qg", x);
-        return string(s);
-    }
-#elif FLOAT_PRECISION_BITS == 80
-    typedef long double FLOAT;
-    #include <cmath>
-    #include <cfloat>
-    #define EXP expl
-    #define LOG logl
-    #define GAMMA tgammal
-    #define LOG_GAMMA lgammal
-    #define POW powl
-    #define FREXP frexpl
-    #define LDEXP ldexpl
-    #define MAX_EXP LDBL_MAX_EXP
-    #define TO_STRING long_double_to_string
-#elif FLOAT_PRECISION_BITS == 64
-    typedef double FLOAT;
-    #include <cmath>
-    #include <cfloat>
-    #define EXP exp
-    #define LOG log
-    #define GAMMA tgamma
-    #define LOG_GAMMA lgamma
-    #define POW pow
-    #define FREXP frexp
-    #define LDEXP ldexp
-    #define MAX_EXP DBL_MAX_EXP
-    #define TO_STRING double_to_string
-#else
-    #error FLOAT_PRECISION_BITS must be 64, 80 or 128.
-#endif
-
-
-static string long_double_to_string(long double x)
-{
-    stringstream ss;
-    ss.precision(22);
-    ss << x;
-    return ss.str();
-}
-
-class PolynomialTranslatedMonomials {
-public:
-    PolynomialTranslatedMonomials(int max_degree);
-    ~PolynomialTranslatedMonomials();
-    FLOAT get_multiplicative_coefficient(int degree) const;
-    void set_multiplicative_coefficient(int degree, FLOAT multiplicative_coefficient);
-    void set_additive_coefficient(int degree, FLOAT additive_coefficient);
-    FLOAT evaluate(FLOAT x) const;
-    void integrate();
-    void ldexp_all_multiplicative_coefficients(int exp);
-    friend ostream& operator<<(ostream& stream, const PolynomialTranslatedMonomials& poly);
-    int degree;
-private:
-    FLOAT* __restrict__ multiplicative_coefficients;
-    FLOAT* __restrict__ additive_coefficients;
-};
-
-PolynomialTranslatedMonomials::PolynomialTranslatedMonomials(int max_degree) :
-    degree(0)
-{
-    assert(max_degree >= 0);
-    multiplicative_coefficients = (FLOAT*)_mm_malloc(sizeof(FLOAT)*(max_degree+1), 32);
-    additive_coefficients = (FLOAT*)_mm_malloc(sizeof(FLOAT)*(max_degree+1), 32);
-    memset(multiplicative_coefficients, 0, sizeof(FLOAT)*(max_degree+1));
-    memset(additive_coefficients, 0, sizeof(FLOAT)*(max_degree+1));
-}
-
-PolynomialTranslatedMonomials::~PolynomialTranslatedMonomials()
-{
-    _mm_free(multiplicative_coefficients);
-    _mm_free(additive_coefficients);
-}
-
-FLOAT PolynomialTranslatedMonomials::get_multiplicative_coefficient(int degree) const
-{
-    assert(degree >= 0);
-    assert(degree <= this->degree);
-    return multiplicative_coefficients[degree];
-}
-
-void PolynomialTranslatedMonomials::set_multiplicative_coefficient(int degree, FLOAT multiplicative_coefficient)
-{
-    assert(degree >= 0);
-    assert(degree <= this->degree);
-
-    multiplicative_coefficients[degree] = multiplicative_coefficient;
-}
-
-void PolynomialTranslatedMonomials::set_additive_coefficient(int degree, FLOAT additive_coefficient)
-{
-    assert(degree >= 0);
-    assert(degree <= this->degree);
-
-    additive_coefficients[degree] = additive_coefficient;
-}
-
-FLOAT PolynomialTranslatedMonomials::evaluate(FLOAT x) const
-{
-    FLOAT result = 0.0;
-    for (int i = 0; i < degree+1; ++i) {
-        result += multiplicative_coefficients[i] * POW(x+additive_coefficients[i], i);
-    }
-    return result;
-}
-
-void PolynomialTranslatedMonomials::integrate()
-{
-    for (int i = degree+1; i >= 1; --i) {
-        multiplicative_coefficients[i] = multiplicative_coefficients[i-1] / FLOAT(i);
-        additive_coefficients[i] = additive_coefficients[i-1];
-    }
-    additive_coefficients[1] = 0.0;
-    additive_coefficients[0] = 0.0;
-    multiplicative_coefficients[0] = 0.0;
-    ++degree;
-}
-
-void PolynomialTranslatedMonomials::ldexp_all_multiplicative_coefficients(int exp)
-{
-    for (int i = 0; i < degree+1; ++i) {
-        multiplicative_coefficients[i] = LDEXP(multiplicative_coefficients[i], exp);
-    }
-}
-
-ostream& operator<<(ostream& stream, const PolynomialTranslatedMonomials& poly)
-{
-    for (int i = poly.degree; i >= 0; --i) {
-        FLOAT coef = poly.multiplicative_coefficients[i];
-        if (coef >= 0) {
-            stream << (i != poly.degree ? " + " : "") << TO_STRING(coef);
-            
-        } else {
-            stream << (i != poly.degree ? " - " : "") << TO_STRING(-coef);
-        }
-        if (i >= 1) {
-            stream << " (x + " << TO_STRING(poly.additive_coefficients[i]) << ")^" << i;
-        }
-    }
-    return stream;
-}
-
 static FLOAT maximum_multiplicative_coefficient(const PolynomialTranslatedMonomials& p)
 {
     assert(p.degree >= 1);
@@ -189,7 +25,7 @@ static FLOAT maximum_multiplicative_coefficient(const PolynomialTranslatedMonomi
 
 static int extract_exponent(FLOAT x)
 {
-    static int exponent;
+    int exponent;
     FREXP(x, &exponent);
     return exponent;
 }
@@ -2,12 +2,18 @@
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <sstream>
+#include <cassert>
 
 #include "ecdf1_new.hh"
 #include "common.hh"
 #include "poisson_pmf.hh"
 #include "fftwconvolver.hh"
+#include "computation_context.hh"
+#include "checkpoints.hh"
+#include "jump_size.hh"
 #include "aligned_mem.hh"
+#include "memory_usage.hh"
 #include "string_utils.hh"
 
 using namespace std;
@@ -21,25 +27,52 @@ void print_double_array(const double* arr, int n)
     cout << "\b\b]";
 }
 
-vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const vector<double>& B, int jump_size)
+static void check_context_size(int n, const ComputationContext& ctx)
 {
-    assert(jump_size <= n);
+    if (ctx.get_n() < n) {
+        stringstream ss;
+        ss << "ComputationContext was created for n<=" << ctx.get_n() << " but is used with n==" << n;
+        throw runtime_error(ss.str());
+    }
+    if (ctx.get_max_window_size() < n+1) {
+        throw runtime_error("ecdf1_new_b() and ecdf1_new_B() can't use the ComputationContext of ecdf2_low_memory().");
+    }
+}
+
+// If jump_size is 0, the jump size of each block is chosen by tuned_jump_size() according to the size of the active window.
+static vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const double* B, int B_size, int jump_size, ComputationContext& ctx, NoncrossingCheckpoints* checkpoints)
+{
+    assert((jump_size >= 0) && (jump_size <= n));
+    check_context_size(n, ctx);
     DoubleBuffer<double> buffers(n+1, 0.0);
-    DoubleBuffer<double> minibuffers(jump_size, 0.0);
+    DoubleBuffer<double> minibuffers((jump_size > 0) ? jump_size : n+1, 0.0);
+    ScopedAllocation buffers_allocation(2*(n+1 + ((jump_size > 0) ? jump_size : n+1))*sizeof(double));
     buffers.get_src()[0] = 1.0;
 
-    FFTWConvolver fftconvolver(n+1);
+    FFTWConvolver& fftconvolver = ctx.get_convolver();
+    PoissonPMFGenerator& pmfgen = ctx.get_pmfgen();
 
-    PoissonPMFGenerator pmfgen(n+1);
+    AlignedDoubles tmp_holder(allocate_aligned_doubles(n+1));
+    double* tmp = tmp_holder.get();
 
-    double* tmp = allocate_aligned_doubles(n+1);
-
-    int n_steps = B.size();
+    int n_steps = B_size;
     double I_prev_location = 0.0;
     int I_prev = -1;
-    int I = min(I_prev+jump_size, n_steps-1);
+    if (checkpoints != NULL) {
+        vector<double> parameters = {double(n), intensity, double(jump_size)};
+        const Checkpoint* checkpoint = checkpoints->resume(parameters, vector<double>(B, B+B_size), vector<int>(n_steps, 0));
+        if (checkpoint != NULL) {
+            I_prev = checkpoint->step - 1;
+            I_prev_location = checkpoint->location;
+            buffers.get_src() = checkpoint->state;
+        }
+    }
+    int I = min(I_prev + ((jump_size > 0) ? jump_size : tuned_jump_size(n-I_prev)), n_steps-1);
     //cout << "n: " << n << endl;
     while (true) {
+        if (checkpoints != NULL) {
+            checkpoints->save_if_due(I_prev+1, I_prev_location, 0, 0, buffers.get_src());
+        }
         //cout << "I: " << I << ", I_prev: " << I_prev << endl;
         //cout << "B[I]: " << B[I] << ", I_prev_location: " << I_prev_location << endl;
 
@@ -68,13 +101,8 @@ vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, con
 
             double prob_exit_now = minibuffers.get_dest()[i-I_prev-1];
             double lambda = intensity*(B[I]-B[i]);
-            for (int j = I+1; j < n+1; ++j) {
-                //cout << "lambda: " << lambda << " j-i: " << j-i << endl;
-                //cout << "prob_exit_now: " << prob_exit_now << endl;
-                //cout << "pmfgen.evaluate_pmf(lambda, j-i): " << pmfgen.evaluate_pmf(lambda, j-i) << endl;
-                //cout << "buffers.get_dest()[j]:" << buffers.get_dest()[j] << endl;
-                buffers.get_dest()[j] -= prob_exit_now * pmfgen.evaluate_pmf(lambda, j-i);
-            }
+            // buffers.get_dest()[j] -= prob_exit_now * Pr[Pois(lambda) = j-i] for j=I+1,...,n
+            pmfgen.subtract_scaled_pmf(prob_exit_now, lambda, I+1-i, n-I, &buffers.get_dest()[I+1]);
 
             minibuffers.get_dest()[i-I_prev-1] = 0.0;
             minibuffers.get_src()[i-I_prev-1] = 0.0;
@@ -91,7 +119,7 @@ vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, con
         }
 
         //cout << "I: " << I << " I_prev: " << I_prev << endl;
-        I = min(I+jump_size, n_steps-1);
+        I = min(I + ((jump_size > 0) ? jump_size : tuned_jump_size(n-I_prev)), n_steps-1);
         //cout << "I: " << I << " I_prev: " << I_prev << endl;
     }
     //cout << "FINAL step\n";
@@ -107,28 +135,63 @@ vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, con
     fftconvolver.convolve_same_size(n-n_steps+1, pmfgen.get_array(), &buffers.get_src()[n_steps], &buffers.get_dest()[n_steps]);
     fill(&buffers.get_dest()[0], &buffers.get_dest()[n_steps], 0.0);
 
-    free_aligned_mem(tmp);
     return buffers.get_dest();
 }
 
+vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const vector<double>& B, int jump_size, ComputationContext& ctx)
+{
+    return poisson_B_noncrossing_probability_n2(n, intensity, B.data(), B.size(), jump_size, ctx, NULL);
+}
+
+vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const double* B, int B_size, int jump_size, ComputationContext& ctx)
+{
+    return poisson_B_noncrossing_probability_n2(n, intensity, B, B_size, jump_size, ctx, NULL);
+}
+
+vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const vector<double>& B, int jump_size, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints)
+{
+    return poisson_B_noncrossing_probability_n2(n, intensity, B.data(), B.size(), jump_size, ctx, &checkpoints);
+}
+
 double ecdf1_new_B(const vector<double>& B)
+{
+    ComputationContext ctx(B.size());
+    return ecdf1_new_B(B, ctx);
+}
+
+static double ecdf1_new_B(const double* B, int B_size, ComputationContext& ctx, NoncrossingCheckpoints* checkpoints)
 {
     //cout << "Called ecdf1_new_B()\n";
-    int n = B.size();
-    check_boundary_vector("B", n, B);
+    int n = B_size;
+    check_boundary_array("B", n, B, B_size);
 
-    // Asymptotically any k in the range [logn, n/logn] should give optimal results as n goes to infinity.
-    // Setting k=c*sqrt(n) and minimizing the asymptotic runtime, we obtain k=sqrt(2*n),
-    // however, empirically slightly lower numbers give better results.
-    int k = sqrt(n) + 1; // The +1 is to prevent it from being zero for small array sizes.
+    // The jump size is chosen for each block, see jump_size.hh.
+    vector<double> poisson_nocross_probabilities = poisson_B_noncrossing_probability_n2(n, n, B, B_size, 0, ctx, checkpoints);
+    return poisson_nocross_probabilities[n] / poisson_pmf(n, n);
+}
+
+double ecdf1_new_B(const vector<double>& B, ComputationContext& ctx)
+{
+    return ecdf1_new_B(B.data(), B.size(), ctx, NULL);
+}
 
+double ecdf1_new_B(const double* B, int B_size, ComputationContext& ctx)
+{
+    return ecdf1_new_B(B, B_size, ctx, NULL);
+}
 
-    vector<double> poisson_nocross_probabilities = poisson_B_noncrossing_probability_n2(n, n, B, k);
-    return poisson_nocross_probabilities[n] / poisson_pmf(n, n);
+double ecdf1_new_B(const vector<double>& B, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints)
+{
+    return ecdf1_new_B(B.data(), B.size(), ctx, &checkpoints);
 }
-// For n=10000, best results k=400...600
 
 double ecdf1_new_b(const vector<double>& b)
+{
+    ComputationContext ctx(b.size());
+    return ecdf1_new_b(b, ctx);
+}
+
+double ecdf1_new_b(const vector<double>& b, ComputationContext& ctx)
 {
     //cout << "Called ecdf1_new_b()\n";
     int n = b.size();
@@ -139,5 +202,5 @@ double ecdf1_new_b(const vector<double>& b)
         symmetric_steps[i] = 1.0 - b[b.size() - 1 - i];
     }
 
-    return ecdf1_new_B(symmetric_steps);
+    return ecdf1_new_B(symmetric_steps, ctx);
 }
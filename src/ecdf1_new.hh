@@ -1,10 +1,31 @@
-
 #ifndef __ecdf1_new_hh__
 #define __ecdf1_new_hh__
 
 #include <vector>
 
+class ComputationContext;
+class NoncrossingCheckpoints;
+
 double ecdf1_new_B(const std::vector<double>& B);
 double ecdf1_new_b(const std::vector<double>& b);
 
+// Same as above, but reuse the FFT plans and buffers of ctx, which must have been created with ctx.get_n() >= n.
+double ecdf1_new_B(const std::vector<double>& B, ComputationContext& ctx);
+double ecdf1_new_b(const std::vector<double>& b, ComputationContext& ctx);
+
+// Same as ecdf1_new_B(B, ctx), but reads the B_size bounds from the array B without copying them.
+double ecdf1_new_B(const double* B, int B_size, ComputationContext& ctx);
+
+// Same as above, but resume from the checkpoints of a previous call whose boundary shares a prefix with B.
+// There is no such variant of ecdf1_new_b(), since it processes b in reverse order.
+double ecdf1_new_B(const std::vector<double>& B, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints);
+
+// Returns a vector whose k-th entry (k=0,...,n) is the probability that a Poisson process on [0,1] with the given
+// intensity has exactly k arrivals and that its arrival times satisfy T_i <= B_i.
+// Processes jump_size steps of B at a time, see Moscovich (2020). If jump_size is 0, it is chosen for each block
+// by tuned_jump_size(), see jump_size.hh.
+std::vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const std::vector<double>& B, int jump_size, ComputationContext& ctx);
+std::vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const std::vector<double>& B, int jump_size, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints);
+std::vector<double> poisson_B_noncrossing_probability_n2(int n, double intensity, const double* B, int B_size, int jump_size, ComputationContext& ctx);
+
 #endif
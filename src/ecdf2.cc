@@ -10,119 +10,484 @@
 
 #include "ecdf2.hh"
 #include "fftwconvolver.hh"
+#include "computation_context.hh"
+#include "sorted_bounds.hh"
+#include "checkpoints.hh"
 #include "aligned_mem.hh"
+#include "memory_usage.hh"
 #include "common.hh"
 #include "poisson_pmf.hh"
 #include "string_utils.hh"
 #include "read_boundaries_file.hh"
+#include "error_estimate.hh"
 
 using namespace std;
 
-enum BoundType {bSTEP, BSTEP, END};  
-
-struct Bound {
-    double location;
-    BoundType tag;
-};
-
-// Needed for using sort()
-static bool operator<(Bound b0, Bound b1)
-{
-    return (b0.location < b1.location);
-}
-
-static vector<Bound> join_all_bounds(const vector<double>& b, const vector<double>& B)
-{
-    vector<Bound> bounds;
-    bounds.reserve(b.size()+B.size()+1);
-
-    Bound bound;
-
-    for (int i = 0; i < (int)b.size(); ++i) {
-        bound.location = b[i];
-        bound.tag = bSTEP;
-        bounds.push_back(bound);
-    }
-
-    for (int i = 0; i < (int)B.size(); ++i) {
-        bound.location = B[i];
-        bound.tag = BSTEP;
-        bounds.push_back(bound);
-    }
-
-    sort(bounds.begin(), bounds.end());
-
-    bound.location = 1.0;
-    bound.tag = END;
-    bounds.push_back(bound);
-
-    return bounds;
-}
-
-void update_dest_buffer_and_step_counts(BoundType bound_tag, vector<double>& dest_buffer, int& b_step_count, int& B_step_count)
+// If B_step_states is not NULL, the probability of the state B_step_count just before it is removed by a B step is stored
+// in (*B_step_states)[B_step_count].
+void update_dest_buffer_and_step_counts(BoundType bound_tag, vector<double>& dest_buffer, int& b_step_count, int& B_step_count, vector<double>* B_step_states)
 {
     if (bound_tag == bSTEP) {
         ++b_step_count;
         dest_buffer[b_step_count] = 0.0;
     } else if (bound_tag == BSTEP) {
+        if (B_step_states != NULL) {
+            (*B_step_states)[B_step_count] = dest_buffer[B_step_count];
+        }
         dest_buffer[B_step_count] = 0.0;
         ++B_step_count;
     } else {
-        if (bound_tag != END) {
+        if ((bound_tag != END) && (bound_tag != QUERY)) {
             cout << "tag: " << bound_tag << "\n";
-            throw runtime_error("Expecting END tag");
+            throw runtime_error("Expecting END or QUERY tag");
         }
     }
 }
 
 // TODO: Split function into 2 cases: with_fft and no_fft
-vector<double> poisson_process_noncrossing_probability(int n, double intensity, const vector<double>& b, const vector<double>& B, bool use_fft)
+// Optional outputs of the sweep:
+//     B_step_states: see update_dest_buffer_and_step_counts().
+//     query_results: for each of the sorted query_locations t, the probability that a Poisson process with the given
+//                    intensity does not cross the bounds in [0,t] and has n points in [0,1].
+static vector<double> poisson_process_noncrossing_probability(int n, double intensity, const double* b, int b_size, const double* B, int B_size, bool use_fft, ComputationContext& ctx, NoncrossingCheckpoints* checkpoints, const vector<double>& query_locations, vector<double>* B_step_states, vector<double>* query_results)
 {
-    vector<Bound> bounds = join_all_bounds(b, B);
+    if (ctx.get_n() < n) {
+        stringstream ss;
+        ss << "ComputationContext was created for n<=" << ctx.get_n() << " but is used with n==" << n;
+        throw runtime_error(ss.str());
+    }
+    assert((checkpoints == NULL) || ((B_step_states == NULL) && (query_results == NULL)));
+    // The queries evaluate the PMF at counts up to n.
+    assert((query_results == NULL) || (ctx.get_max_window_size() > n));
+    SortedBounds& bounds = ctx.get_sorted_bounds();
+    join_all_bounds(b, b_size, B, B_size, query_locations, bounds);
 
-    DoubleBuffer<double> buffers(n+1, 0.0);
-    buffers.get_src()[0] = 1.0;
+    // The state is updated in place, each convolution of the window goes through tmp.
+    vector<double> state(n+1, 0.0);
+    ScopedAllocation state_allocation((n+1)*sizeof(double));
+    state[0] = 1.0;
+    AlignedDoubles tmp_holder(allocate_aligned_doubles(ctx.get_max_window_size()));
+    double* tmp = tmp_holder.get();
 
-    FFTWConvolver fftconvolver(n+1); 
-    PoissonPMFGenerator pmfgen(n+1);
+    FFTWConvolver& fftconvolver = ctx.get_convolver();
+    PoissonPMFGenerator& pmfgen = ctx.get_pmfgen();
 
     int b_step_count = 0;
     int B_step_count = 0;
 
     double prev_location = 0.0;
 
-    for (unsigned int i = 0; i < bounds.size(); ++i) {
+    unsigned int first_step = 0;
+    if (checkpoints != NULL) {
+        vector<double> parameters = {double(n), intensity, double(use_fft)};
+        vector<int> tags(bounds.tags.begin(), bounds.tags.end());
+        const Checkpoint* checkpoint = checkpoints->resume(parameters, bounds.locations, tags);
+        if (checkpoint != NULL) {
+            first_step = checkpoint->step;
+            prev_location = checkpoint->location;
+            b_step_count = checkpoint->b_step_count;
+            B_step_count = checkpoint->B_step_count;
+            state = checkpoint->state;
+        }
+    }
+
+    for (unsigned int i = first_step; i < bounds.size(); ++i) {
+        if (checkpoints != NULL) {
+            checkpoints->save_if_due(i, prev_location, b_step_count, B_step_count, state);
+        }
         int cur_size = b_step_count - B_step_count + 1;
+        if (cur_size > ctx.get_max_window_size()) {
+            stringstream ss;
+            ss << "ComputationContext was created for windows of up to " << ctx.get_max_window_size() << " counts but is used with a window of " << cur_size;
+            throw runtime_error(ss.str());
+        }
 
-        double lambda = intensity*(bounds[i].location-prev_location);
+        double lambda = intensity*(bounds.locations[i]-prev_location);
         if (lambda > 0) {
             pmfgen.compute_array(cur_size, lambda);
             if (use_fft) {
-                fftconvolver.convolve_same_size(cur_size, pmfgen.get_array(), &buffers.get_src()[B_step_count], &buffers.get_dest()[B_step_count]);
+                fftconvolver.convolve_same_size(cur_size, pmfgen.get_array(), &state[B_step_count], tmp);
             } else {
-                convolve_same_size(cur_size, pmfgen.get_array(), &buffers.get_src()[B_step_count], &buffers.get_dest()[B_step_count]);
+                convolve_same_size(cur_size, pmfgen.get_array(), &state[B_step_count], tmp);
+                if (ctx.get_error_tracker() != NULL) {
+                    ctx.get_error_tracker()->add_naive_convolution(cur_size);
+                }
             }
-            update_dest_buffer_and_step_counts(bounds[i].tag, buffers.get_dest(), b_step_count, B_step_count);
-            buffers.flip();
-        } else if (lambda==0) {
-            // No need to convolve or copy anything -- just modify src buffer in place.
-            update_dest_buffer_and_step_counts(bounds[i].tag, buffers.get_src(), b_step_count, B_step_count);
-        } else {
+            copy(tmp, tmp+cur_size, &state[B_step_count]);
+        } else if (lambda < 0) {
             throw runtime_error("lambda<0 in poisson_process_noncrossing_probability(). This should never happen.");
         }
-        prev_location = bounds[i].location;
+        // With lambda==0 there is no need to convolve anything, the step just modifies the state in place.
+        update_dest_buffer_and_step_counts(bounds.tags[i], state, b_step_count, B_step_count, B_step_states);
+        prev_location = bounds.locations[i];
+
+        if ((bounds.tags[i] == QUERY) && (query_results != NULL)) {
+            // Let the process run freely from t to 1 and take the probability of ending at n.
+            double remaining_lambda = intensity*(1.0-bounds.locations[i]);
+            double result = 0.0;
+            for (int k = B_step_count; k <= min(b_step_count, n); ++k) {
+                result += state[k] * pmfgen.evaluate_pmf(remaining_lambda, n-k);
+            }
+            query_results->push_back(result);
+        }
     }
-    return buffers.get_src();
+    return state;
+}
+
+// Runs the recursion of poisson_process_noncrossing_probability() for several Poisson processes in lockstep.
+// Since the order of the bounds doesn't depend on the process, they are merged once and the window of each
+// step is shared by all the processes. Process j has mean measure mean_measures[j][i] on [0, bounds.locations[i]].
+// Returns, for each process, the probabilities of having k=0,...,n points without crossing the bounds.
+static vector<vector<double> > poisson_processes_noncrossing_probabilities(int n, const SortedBounds& bounds, const vector<vector<double> >& mean_measures, bool use_fft, ComputationContext& ctx)
+{
+    if (ctx.get_n() < n) {
+        stringstream ss;
+        ss << "ComputationContext was created for n<=" << ctx.get_n() << " but is used with n==" << n;
+        throw runtime_error(ss.str());
+    }
+    int num_processes = mean_measures.size();
+    vector<DoubleBuffer<double> > buffers(num_processes, DoubleBuffer<double>(n+1, 0.0));
+    ScopedAllocation buffers_allocation(2L*num_processes*(n+1)*sizeof(double));
+    for (int j = 0; j < num_processes; ++j) {
+        assert(mean_measures[j].size() == bounds.size());
+        buffers[j].get_src()[0] = 1.0;
+    }
+
+    FFTWConvolver& fftconvolver = ctx.get_convolver();
+    PoissonPMFGenerator& pmfgen = ctx.get_pmfgen();
+
+    int b_step_count = 0;
+    int B_step_count = 0;
+    vector<double> prev_mean_measures(num_processes, 0.0);
+
+    for (unsigned int i = 0; i < bounds.size(); ++i) {
+        int cur_size = b_step_count - B_step_count + 1;
+        int next_b_step_count = b_step_count;
+        int next_B_step_count = B_step_count;
+        for (int j = 0; j < num_processes; ++j) {
+            next_b_step_count = b_step_count;
+            next_B_step_count = B_step_count;
+            double lambda = mean_measures[j][i] - prev_mean_measures[j];
+            if (lambda > 0) {
+                pmfgen.compute_array(cur_size, lambda);
+                if (use_fft) {
+                    fftconvolver.convolve_same_size(cur_size, pmfgen.get_array(), &buffers[j].get_src()[B_step_count], &buffers[j].get_dest()[B_step_count]);
+                } else {
+                    convolve_same_size(cur_size, pmfgen.get_array(), &buffers[j].get_src()[B_step_count], &buffers[j].get_dest()[B_step_count]);
+                }
+                update_dest_buffer_and_step_counts(bounds.tags[i], buffers[j].get_dest(), next_b_step_count, next_B_step_count, NULL);
+                buffers[j].flip();
+            } else if (lambda == 0) {
+                update_dest_buffer_and_step_counts(bounds.tags[i], buffers[j].get_src(), next_b_step_count, next_B_step_count, NULL);
+            } else {
+                throw runtime_error("The mean measure of a Poisson process must be non-decreasing.");
+            }
+            prev_mean_measures[j] = mean_measures[j][i];
+        }
+        b_step_count = next_b_step_count;
+        B_step_count = next_B_step_count;
+    }
+
+    vector<vector<double> > results(num_processes);
+    for (int j = 0; j < num_processes; ++j) {
+        vector<double>& state = buffers[j].get_src();
+        fill(state.begin(), state.begin()+B_step_count, 0.0);
+        fill(state.begin()+b_step_count+1, state.end(), 0.0);
+        results[j].swap(state);
+    }
+    return results;
+}
+
+vector<double> poisson_process_noncrossing_probability(int n, double intensity, const vector<double>& b, const vector<double>& B, bool use_fft, ComputationContext& ctx)
+{
+    return poisson_process_noncrossing_probability(n, intensity, b.data(), b.size(), B.data(), B.size(), use_fft, ctx, NULL, vector<double>(), NULL, NULL);
+}
+
+vector<double> poisson_process_noncrossing_probability(int n, double intensity, const double* b, int b_size, const double* B, int B_size, bool use_fft, ComputationContext& ctx)
+{
+    return poisson_process_noncrossing_probability(n, intensity, b, b_size, B, B_size, use_fft, ctx, NULL, vector<double>(), NULL, NULL);
+}
+
+vector<double> poisson_process_noncrossing_probability(int n, double intensity, const vector<double>& b, const vector<double>& B, bool use_fft, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints)
+{
+    return poisson_process_noncrossing_probability(n, intensity, b.data(), b.size(), B.data(), B.size(), use_fft, ctx, &checkpoints, vector<double>(), NULL, NULL);
 }
 
 double ecdf2(const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    ComputationContext ctx(b.size());
+    return ecdf2(b, B, use_fft, ctx);
+}
+
+double ecdf2(const vector<double>& b, const vector<double>& B, bool use_fft, ComputationContext& ctx)
 {
     int n = b.size();
     check_boundary_vector("b", n, b);
     check_boundary_vector("B", n, B);
 
-    vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability(n, n, b, B, use_fft);
+    vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability(n, n, b, B, use_fft, ctx);
 
     return poisson_nocross_probs[n] / poisson_pmf(n, n);
 }
 
+double ecdf2_low_memory(const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+
+    ComputationContext ctx(n, maximum_window_size(b, B));
+    vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability(n, n, b, B, use_fft, ctx);
+
+    return poisson_nocross_probs[n] / poisson_pmf(n, n);
+}
+
+double ecdf2(const vector<double>& b, const vector<double>& B, bool use_fft, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+
+    vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability(n, n, b, B, use_fft, ctx, checkpoints);
+
+    return poisson_nocross_probs[n] / poisson_pmf(n, n);
+}
+
+// A sweep with intensity lambda gives the noncrossing probabilities of all sample sizes m, scaled by the Poisson
+// probabilities Pr[Pois(lambda) = m]. Far from lambda these are too small compared to the round-off errors of
+// the sweep, so each sweep is only used for the sample sizes within this many standard deviations of lambda.
+const double SAMPLE_SIZE_WINDOW_STDS = 2.0;
+
+vector<double> ecdf2_all_sample_sizes(const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+
+    ComputationContext ctx(n);
+    vector<double> probs(n+1);
+    probs[0] = 1.0;
+
+    const double c = SAMPLE_SIZE_WINDOW_STDS;
+    int m_high = n;
+    while (m_high > 0) {
+        // The sweep covers the sample sizes [lambda - c*sqrt(lambda), lambda + c*sqrt(lambda)] and needs only the first m_high bounds.
+        double sqrt_lambda = 0.5*(-c + sqrt(c*c + 4.0*m_high));
+        double lambda = (m_high == n) ? n : sqrt_lambda*sqrt_lambda;
+        int m_low = max(1, min(m_high, int(ceil(lambda - c*sqrt(lambda)))));
+
+        vector<double> B_step_states(m_high, 0.0);
+        vector<double> poisson_nocross_probs = poisson_process_noncrossing_probability(m_high, lambda, b.data(), m_high, B.data(), m_high, use_fft, ctx, NULL, vector<double>(), &B_step_states, NULL);
+
+        // A sample of size m satisfies the first m bounds iff the Poisson process satisfies them and has m points.
+        // The bounds b_{m+1},...,b_n can't be crossed by such a process, but B_{m+1} always is, so the probability of
+        // the process is taken just before B_{m+1}, and the process must then have no more arrivals.
+        for (int m = m_low; m < m_high; ++m) {
+            double log_pmf = -lambda + m*log(lambda) - lgamma(m+1);
+            probs[m] = B_step_states[m] * exp(-lambda*(1.0-B[m]) - log_pmf);
+        }
+        probs[m_high] = poisson_nocross_probs[m_high] / poisson_pmf(lambda, m_high);
+
+        m_high = m_low - 1;
+    }
+
+    return probs;
+}
+
+vector<double> ecdf2_prefix_noncrossing_probabilities(const vector<double>& b, const vector<double>& B, bool use_fft, const vector<double>& t)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+    for (unsigned int j = 0; j < t.size(); ++j) {
+        if ((t[j] < 0.0) || (t[j] > 1.0) || ((j > 0) && (t[j] < t[j-1]))) {
+            throw runtime_error("ecdf2_prefix_noncrossing_probabilities() expects a sorted list of times in [0,1].");
+        }
+    }
+
+    ComputationContext ctx(n);
+    vector<double> query_results;
+    query_results.reserve(t.size());
+    poisson_process_noncrossing_probability(n, n, b.data(), b.size(), B.data(), B.size(), use_fft, ctx, NULL, t, NULL, &query_results);
+
+    double pmf_n = poisson_pmf(n, n);
+    for (unsigned int j = 0; j < query_results.size(); ++j) {
+        query_results[j] /= pmf_n;
+    }
+    return query_results;
+}
+
+static void check_poisson_bounds(const vector<double>& b, const vector<double>& B)
+{
+    check_boundary_vector("b", b.size(), b);
+    check_boundary_vector("B", B.size(), B);
+    if (B.size() > b.size()) {
+        throw runtime_error("Expecting at most as many upper bounds B_i as lower bounds b_i.");
+    }
+}
+
+vector<vector<double> > poisson_noncrossing_probabilities_by_count(const vector<double>& intensities, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    check_poisson_bounds(b, B);
+    int n = b.size();
+    ComputationContext ctx(n);
+    SortedBounds& bounds = ctx.get_sorted_bounds();
+    join_all_bounds(b, B, vector<double>(), bounds);
+
+    vector<vector<double> > mean_measures(intensities.size(), vector<double>(bounds.size()));
+    for (unsigned int j = 0; j < intensities.size(); ++j) {
+        if (intensities[j] < 0.0) {
+            throw runtime_error("Poisson process intensities must be non-negative.");
+        }
+        for (unsigned int i = 0; i < bounds.size(); ++i) {
+            mean_measures[j][i] = intensities[j]*bounds.locations[i];
+        }
+    }
+
+    return poisson_processes_noncrossing_probabilities(n, bounds, mean_measures, use_fft, ctx);
+}
+
+vector<double> poisson_noncrossing_probabilities(const vector<double>& intensities, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    vector<vector<double> > probs_by_count = poisson_noncrossing_probabilities_by_count(intensities, b, B, use_fft);
+    vector<double> probs(probs_by_count.size());
+    for (unsigned int j = 0; j < probs_by_count.size(); ++j) {
+        probs[j] = accumulate(probs_by_count[j].begin(), probs_by_count[j].end(), 0.0);
+    }
+    return probs;
+}
+
+vector<double> poisson_noncrossing_probability_by_count(double intensity, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    return poisson_noncrossing_probabilities_by_count(vector<double>(1, intensity), b, B, use_fft)[0];
+}
+
+double poisson_noncrossing_probability(double intensity, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    return poisson_noncrossing_probabilities(vector<double>(1, intensity), b, B, use_fft)[0];
+}
+
+static void check_warp(const vector<double>& warp_x, const vector<double>& warp_y)
+{
+    if (warp_y.size() < 2) {
+        throw runtime_error("A warp must have at least 2 points.");
+    }
+    if (!warp_x.empty()) {
+        if (warp_x.size() != warp_y.size()) {
+            throw runtime_error("The x and y coordinates of a warp must have the same length.");
+        }
+        if ((warp_x.front() > 0.0) || (warp_x.back() < 1.0)) {
+            throw runtime_error("The x coordinates of a warp must cover the interval [0,1].");
+        }
+        for (unsigned int k = 1; k < warp_x.size(); ++k) {
+            if (warp_x[k] <= warp_x[k-1]) {
+                throw runtime_error("The x coordinates of a warp must be strictly increasing.");
+            }
+        }
+    }
+    for (unsigned int k = 1; k < warp_y.size(); ++k) {
+        if (warp_y[k] < warp_y[k-1]) {
+            throw runtime_error("The y coordinates of a warp must be non-decreasing.");
+        }
+    }
+}
+
+// Evaluates the piecewise linear function through the points (warp_x[k], warp_y[k]) at the locations of the
+// sorted bounds, relative to its value at 0. If warp_x is empty, the points are on the uniform grid k/(K-1).
+// Since the bounds are sorted, this is a single merge of the bounds with the knots.
+static void evaluate_warp(const vector<double>& warp_x, const vector<double>& warp_y, const SortedBounds& bounds, vector<double>& values)
+{
+    int K = warp_y.size();
+    double grid_step = 1.0 / (K-1);
+    values.resize(bounds.size());
+
+    int k = 0;
+    double value_at_0 = 0.0;
+    for (int i = -1; i < (int)bounds.size(); ++i) {
+        double t = (i == -1) ? 0.0 : bounds.locations[i];
+        double value;
+        if (warp_x.empty()) {
+            k = min(int(t/grid_step), K-2);
+            double fraction = t/grid_step - k;
+            value = warp_y[k] + fraction*(warp_y[k+1] - warp_y[k]);
+        } else {
+            while ((k < K-2) && (warp_x[k+1] < t)) {
+                ++k;
+            }
+            double fraction = (t - warp_x[k]) / (warp_x[k+1] - warp_x[k]);
+            value = warp_y[k] + fraction*(warp_y[k+1] - warp_y[k]);
+        }
+        if (i == -1) {
+            value_at_0 = value;
+        } else {
+            // Guard against the monotonicity being broken by rounding.
+            values[i] = max(value - value_at_0, (i > 0) ? values[i-1] : 0.0);
+        }
+    }
+}
+
+vector<vector<double> > poisson_noncrossing_probabilities_by_count_warped(const vector<vector<double> >& warps_x, const vector<vector<double> >& warps_y, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    check_poisson_bounds(b, B);
+    if (warps_x.size() != warps_y.size()) {
+        throw runtime_error("Expecting the same number of x and y coordinate lists for the warps.");
+    }
+    int n = b.size();
+    ComputationContext ctx(n);
+    SortedBounds& bounds = ctx.get_sorted_bounds();
+    join_all_bounds(b, B, vector<double>(), bounds);
+
+    vector<vector<double> > mean_measures(warps_y.size());
+    for (unsigned int j = 0; j < warps_y.size(); ++j) {
+        check_warp(warps_x[j], warps_y[j]);
+        evaluate_warp(warps_x[j], warps_y[j], bounds, mean_measures[j]);
+    }
+
+    return poisson_processes_noncrossing_probabilities(n, bounds, mean_measures, use_fft, ctx);
+}
+
+vector<double> poisson_noncrossing_probabilities_warped(const vector<vector<double> >& warps_x, const vector<vector<double> >& warps_y, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    vector<vector<double> > probs_by_count = poisson_noncrossing_probabilities_by_count_warped(warps_x, warps_y, b, B, use_fft);
+    vector<double> probs(probs_by_count.size());
+    for (unsigned int j = 0; j < probs_by_count.size(); ++j) {
+        probs[j] = accumulate(probs_by_count[j].begin(), probs_by_count[j].end(), 0.0);
+    }
+    return probs;
+}
+
+vector<double> ecdf2_warped(const vector<vector<double> >& warps_x, const vector<vector<double> >& warps_y, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+    if (warps_x.size() != warps_y.size()) {
+        throw runtime_error("Expecting the same number of x and y coordinate lists for the warps.");
+    }
+    for (unsigned int j = 0; j < warps_y.size(); ++j) {
+        check_warp(warps_x[j], warps_y[j]);
+        if ((warps_y[j].front() != 0.0) || (warps_y[j].back() != 1.0)) {
+            throw runtime_error("ecdf2_warped() expects each warp to be a CDF, going from 0 to 1.");
+        }
+    }
+
+    // The sample is uniform after applying the CDF, so it behaves like a Poisson process with mean measure n*F(t).
+    vector<vector<double> > scaled_warps_y(warps_y);
+    for (unsigned int j = 0; j < scaled_warps_y.size(); ++j) {
+        for (unsigned int k = 0; k < scaled_warps_y[j].size(); ++k) {
+            scaled_warps_y[j][k] *= n;
+        }
+    }
+    vector<vector<double> > probs_by_count = poisson_noncrossing_probabilities_by_count_warped(warps_x, scaled_warps_y, b, B, use_fft);
+
+    vector<double> probs(probs_by_count.size());
+    for (unsigned int j = 0; j < probs_by_count.size(); ++j) {
+        probs[j] = probs_by_count[j][n] / poisson_pmf(n, n);
+    }
+    return probs;
+}
+
+double ecdf2_warped(const vector<double>& warp_x, const vector<double>& warp_y, const vector<double>& b, const vector<double>& B, bool use_fft)
+{
+    return ecdf2_warped(vector<vector<double> >(1, warp_x), vector<vector<double> >(1, warp_y), b, B, use_fft)[0];
+}
@@ -3,6 +3,71 @@
 
 #include <vector>
 
+class ComputationContext;
+class NoncrossingCheckpoints;
+
 double ecdf2(const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
 
+// Same as above, but reuse the FFT plans and buffers of ctx, which must have been created with ctx.get_n() >= n.
+double ecdf2(const std::vector<double>& b, const std::vector<double>& B, bool use_fft, ComputationContext& ctx);
+
+// Same as above, but resume from the checkpoints of a previous call whose boundaries share a prefix with b, B.
+double ecdf2(const std::vector<double>& b, const std::vector<double>& B, bool use_fft, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints);
+
+// Same as ecdf2(b, B, use_fft), with the FFT buffers and Poisson PMF tables sized to the largest active window
+// between the bounds rather than to n. For narrow two-sided bounds such as Kolmogorov-Smirnov this needs about
+// 8n bytes instead of about 64n bytes, see peak_allocated_bytes() in memory_usage.hh.
+double ecdf2_low_memory(const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Returns a vector whose m-th entry (m=0,...,n) is the noncrossing probability of a sample of size m with
+// the first m bounds, i.e. ecdf2(b[0:m], B[0:m], use_fft). Each Poisson sweep yields the sample sizes within a few
+// standard deviations of its intensity, so O(sqrt(n)) sweeps are needed instead of n calls to ecdf2().
+std::vector<double> ecdf2_all_sample_sizes(const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Returns a vector whose j-th entry is the probability that the empirical CDF of a sample of size n does not cross
+// the boundaries in the interval [0,t_j]. This is the same as ecdf2(b', B', use_fft) where b'_i = min(b_i, t_j)
+// and B'_i = B_i if B_i <= t_j, otherwise B'_i = 1. The times t_j must be sorted. All the entries are computed in a single pass.
+std::vector<double> ecdf2_prefix_noncrossing_probabilities(const std::vector<double>& b, const std::vector<double>& B, bool use_fft, const std::vector<double>& t);
+
+// The probability that the arrival times T_1 <= T_2 <= ... of a homogeneous Poisson process on [0,1]
+// with the given intensity satisfy
+//     b_i <= T_i for i=1,...,n and T_i <= B_i for i=1,...,m
+// where n = b.size() >= m = B.size(). In particular, the process has at most n arrivals.
+// To leave the arrival times unconstrained from below, set b_i = 0.
+double poisson_noncrossing_probability(double intensity, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Same as above, split by the number of arrivals. The k-th entry (k=0,...,n) is the probability
+// that the process satisfies the bounds and has exactly k arrivals.
+std::vector<double> poisson_noncrossing_probability_by_count(double intensity, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Same as the two functions above for several intensities at once. The bounds are sorted only once
+// and all the processes are advanced together in a single sweep.
+std::vector<double> poisson_noncrossing_probabilities(const std::vector<double>& intensities, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+std::vector<std::vector<double> > poisson_noncrossing_probabilities_by_count(const std::vector<double>& intensities, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// A warp is a non-decreasing piecewise linear function through the points (x_k, y_k), where x_0 <= 0 < ... < x_K >= 1.
+// If x is empty, the points are taken on the uniform grid x_k = k/K, so y is simply a table of samples.
+// Warps are applied to the sorted bounds as part of the sweep, so many warps can be evaluated without
+// transforming and re-sorting the bounds.
+
+// The noncrossing probability ecdf2(b, B) of a sample drawn from the distribution whose CDF F is the given warp,
+// rather than the uniform distribution. F must satisfy F(0)=0 and F(1)=1.
+// This is the same as ecdf2(F(b), F(B)) but without transforming the bounds.
+double ecdf2_warped(const std::vector<double>& warp_x, const std::vector<double>& warp_y, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Same as above for several warps at once, in a single sweep.
+std::vector<double> ecdf2_warped(const std::vector<std::vector<double> >& warps_x, const std::vector<std::vector<double> >& warps_y, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Same as poisson_noncrossing_probabilities(), for non-homogeneous Poisson processes. The j-th warp is the cumulative
+// intensity of the j-th process, i.e. the expected number of arrivals in [0,t] is warp_j(t) - warp_j(0).
+std::vector<double> poisson_noncrossing_probabilities_warped(const std::vector<std::vector<double> >& warps_x, const std::vector<std::vector<double> >& warps_y, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+std::vector<std::vector<double> > poisson_noncrossing_probabilities_by_count_warped(const std::vector<std::vector<double> >& warps_x, const std::vector<std::vector<double> >& warps_y, const std::vector<double>& b, const std::vector<double>& B, bool use_fft);
+
+// Returns a vector whose k-th entry (k=0,...,n) is the probability that a Poisson process on [0,1] with the given
+// intensity has exactly k arrivals and that its arrival times T_1 <= T_2 <= ... satisfy b_i <= T_i <= B_i.
+std::vector<double> poisson_process_noncrossing_probability(int n, double intensity, const std::vector<double>& b, const std::vector<double>& B, bool use_fft, ComputationContext& ctx);
+std::vector<double> poisson_process_noncrossing_probability(int n, double intensity, const std::vector<double>& b, const std::vector<double>& B, bool use_fft, ComputationContext& ctx, NoncrossingCheckpoints& checkpoints);
+// Same as above with the bounds given as arrays, as used by array_interface.hh.
+std::vector<double> poisson_process_noncrossing_probability(int n, double intensity, const double* b, int b_size, const double* B, int B_size, bool use_fft, ComputationContext& ctx);
+
 #endif
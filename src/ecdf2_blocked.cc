@@ -0,0 +1,192 @@
+#include <vector>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <sstream>
+#include <cassert>
+
+#include "ecdf2_blocked.hh"
+#include "common.hh"
+#include "poisson_pmf.hh"
+#include "fftwconvolver.hh"
+#include "computation_context.hh"
+#include "sorted_bounds.hh"
+#include "aligned_mem.hh"
+#include "memory_usage.hh"
+#include "jump_size.hh"
+#include "error_estimate.hh"
+
+using namespace std;
+
+// Paths that start more than this many counts below the top of the window are assumed not to reach the
+// top of the window during a block of steps with mean measure lambda. The neglected Poisson tail probability
+// is below NEGLECTED_TOP_BAND_MASS, far less than the round-off error of the FFT convolutions.
+const double NEGLECTED_TOP_BAND_MASS = 1e-20;
+int ecdf2_blocked_top_band_depth(double lambda)
+{
+    return int(ceil(lambda + 10.0*sqrt(lambda) + 20.0));
+}
+
+// Convolves the state on the counts [low, high] with Pr[Pois(lambda)=k] in place, dropping the mass above high.
+static void convolve_window(int low, int high, double lambda, double* state, double* tmp, ComputationContext& ctx)
+{
+    if (lambda == 0.0) {
+        return;
+    }
+    int size = high - low + 1;
+    PoissonPMFGenerator& pmfgen = ctx.get_pmfgen();
+    pmfgen.compute_array(size, lambda);
+    ctx.get_convolver().convolve_same_size(size, pmfgen.get_array(), &state[low], tmp);
+    copy(tmp, tmp+size, &state[low]);
+}
+
+vector<double> poisson_process_noncrossing_probability_blocked(int n, double intensity, const vector<double>& b, const vector<double>& B, int jump_size, ComputationContext& ctx)
+{
+    return poisson_process_noncrossing_probability_blocked(n, intensity, b.data(), b.size(), B.data(), B.size(), jump_size, ctx);
+}
+
+vector<double> poisson_process_noncrossing_probability_blocked(int n, double intensity, const double* b, int b_size, const double* B, int B_size, int jump_size, ComputationContext& ctx)
+{
+    if (ctx.get_n() < n) {
+        stringstream ss;
+        ss << "ComputationContext was created for n<=" << ctx.get_n() << " but is used with n==" << n;
+        throw runtime_error(ss.str());
+    }
+    if (ctx.get_max_window_size() < n+1) {
+        throw runtime_error("ecdf2_blocked() can't use the ComputationContext of ecdf2_low_memory().");
+    }
+    if (jump_size < 0) {
+        throw runtime_error("poisson_process_noncrossing_probability_blocked() expects a non-negative jump_size.");
+    }
+    SortedBounds& bounds = ctx.get_sorted_bounds();
+    join_all_bounds(b, b_size, B, B_size, vector<double>(), bounds);
+    const double* locations = bounds.locations.data();
+    const BoundType* tags = bounds.tags.data();
+    int n_steps = bounds.size();
+
+    PoissonPMFGenerator& pmfgen = ctx.get_pmfgen();
+
+    // The state is kept zero outside of the window [B_step_count, b_step_count].
+    vector<double> state(n+1, 0.0);
+    state[0] = 1.0;
+    AlignedDoubles tmp_holder(allocate_aligned_doubles(n+1));
+    double* tmp = tmp_holder.get();
+    vector<double> low_band(n+1, 0.0);
+    vector<double> top_band(n+1, 0.0);
+    ScopedAllocation vectors_allocation(3*(n+1)*sizeof(double));
+    vector<double> exit_probs;
+    vector<double> exit_locations;
+    vector<int> exit_counts;
+
+    int b_step_count = 0;
+    int B_step_count = 0;
+    double prev_location = 0.0;
+
+    int I_prev = 0;
+    while (I_prev < n_steps) {
+        // The block is the steps [I_prev, I), limited to k steps and a mean measure of k.
+        // With jump_size 0, k is tuned to the current window, which is narrow for two-sided bounds like Kolmogorov-Smirnov.
+        int k = (jump_size > 0) ? jump_size : tuned_jump_size(b_step_count - B_step_count + 1);
+        int I = I_prev + 1;
+        while ((I < n_steps) && (I - I_prev < k) && (intensity*(locations[I]-prev_location) <= k)) {
+            ++I;
+        }
+        int next_b_step_count = b_step_count;
+        int next_B_step_count = B_step_count;
+        for (int i = I_prev; i < I; ++i) {
+            next_b_step_count += (tags[i] == bSTEP);
+            next_B_step_count += (tags[i] == BSTEP);
+        }
+        double block_location = locations[I-1];
+        double block_lambda = intensity*(block_location-prev_location);
+        int top_low = b_step_count - ecdf2_blocked_top_band_depth(block_lambda);
+
+        if ((I - I_prev == 1) || (top_low <= next_B_step_count)) {
+            // The window is narrow, so the steps are done one at a time as in poisson_process_noncrossing_probability().
+            for (int i = I_prev; i < I; ++i) {
+                convolve_window(B_step_count, b_step_count, intensity*(locations[i]-prev_location), &state[0], tmp, ctx);
+                if (tags[i] == bSTEP) {
+                    ++b_step_count;
+                } else if (tags[i] == BSTEP) {
+                    state[B_step_count] = 0.0;
+                    ++B_step_count;
+                }
+                prev_location = locations[i];
+            }
+            I_prev = I;
+            continue;
+        }
+
+        // A single large convolution moves the state to the end of the block, ignoring the bounds inside the block.
+        // Since counts only increase, the counts [B_step_count, next_B_step_count] form a self-contained system which is
+        // computed exactly with small convolutions. The probability of each path that exits this system through a B step is
+        // then subtracted from the large convolution. These paths can't reach the counts above b_step_count, so the bottom and
+        // the top of the window don't interact.
+        fill(low_band.begin()+B_step_count, low_band.begin()+next_B_step_count+1, 0.0);
+        copy(state.begin()+B_step_count, state.begin()+next_B_step_count+1, low_band.begin()+B_step_count);
+        fill(top_band.begin()+top_low, top_band.begin()+next_b_step_count+1, 0.0);
+        copy(state.begin()+top_low, state.begin()+b_step_count+1, top_band.begin()+top_low);
+
+        if (ctx.get_error_tracker() != NULL) {
+            ctx.get_error_tracker()->add_truncation(NEGLECTED_TOP_BAND_MASS);
+        }
+        pmfgen.compute_array(next_b_step_count-B_step_count+1, block_lambda);
+        ctx.get_convolver().convolve_same_size(next_b_step_count-B_step_count+1, pmfgen.get_array(), &state[B_step_count], tmp);
+        copy(tmp, tmp+next_b_step_count-B_step_count+1, &state[B_step_count]);
+
+        exit_probs.clear();
+        exit_locations.clear();
+        exit_counts.clear();
+        int low_B_step_count = B_step_count;
+        int top_b_step_count = b_step_count;
+        double i_prev_location = prev_location;
+        for (int i = I_prev; i < I; ++i) {
+            double lambda = intensity*(locations[i]-i_prev_location);
+            convolve_window(low_B_step_count, next_B_step_count, lambda, &low_band[0], tmp, ctx);
+            convolve_window(top_low, top_b_step_count, lambda, &top_band[0], tmp, ctx);
+            if (tags[i] == bSTEP) {
+                ++top_b_step_count;
+            } else if (tags[i] == BSTEP) {
+                exit_probs.push_back(low_band[low_B_step_count]);
+                exit_locations.push_back(locations[i]);
+                exit_counts.push_back(low_B_step_count);
+                low_band[low_B_step_count] = 0.0;
+                ++low_B_step_count;
+            }
+            i_prev_location = locations[i];
+        }
+
+        // The bottom count of the new window comes from the exact small system and the top counts from the top band.
+        for (unsigned int e = 0; e < exit_probs.size(); ++e) {
+            double lambda = intensity*(block_location-exit_locations[e]);
+            // state[k] -= exit_probs[e] * Pr[Pois(lambda) = k-exit_counts[e]] for k=next_B_step_count+1,...,b_step_count
+            pmfgen.subtract_scaled_pmf(exit_probs[e], lambda, next_B_step_count+1-exit_counts[e], b_step_count-next_B_step_count, &state[next_B_step_count+1]);
+        }
+        fill(state.begin()+B_step_count, state.begin()+next_B_step_count, 0.0);
+        state[next_B_step_count] = low_band[next_B_step_count];
+        copy(top_band.begin()+b_step_count+1, top_band.begin()+next_b_step_count+1, state.begin()+b_step_count+1);
+
+        b_step_count = next_b_step_count;
+        B_step_count = next_B_step_count;
+        prev_location = block_location;
+        I_prev = I;
+    }
+
+    return state;
+}
+
+double ecdf2_blocked(const vector<double>& b, const vector<double>& B)
+{
+    ComputationContext ctx(b.size());
+    return ecdf2_blocked(b, B, ctx);
+}
+
+double ecdf2_blocked(const vector<double>& b, const vector<double>& B, ComputationContext& ctx)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+
+    vector<double> poisson_nocross_probabilities = poisson_process_noncrossing_probability_blocked(n, n, b, B, 0, ctx);
+    return poisson_nocross_probabilities[n] / poisson_pmf(n, n);
+}
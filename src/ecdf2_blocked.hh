@@ -0,0 +1,30 @@
+#ifndef __ecdf2_blocked_hh__
+#define __ecdf2_blocked_hh__
+
+#include <vector>
+
+class ComputationContext;
+
+// Same as ecdf2(b, B, true), using an O(n^2) algorithm that processes about sqrt(w) steps of the boundaries
+// with each large FFT convolution of the active window of size w, similar to ecdf1_new_B().
+// For two-sided bounds with a narrow window, such as Kolmogorov-Smirnov, this is O(n*sqrt(w)*log(w)).
+double ecdf2_blocked(const std::vector<double>& b, const std::vector<double>& B);
+
+// Same as above, but reuse the FFT plans and buffers of ctx, which must have been created with ctx.get_n() >= n.
+double ecdf2_blocked(const std::vector<double>& b, const std::vector<double>& B, ComputationContext& ctx);
+
+// Same as poisson_process_noncrossing_probability(n, intensity, b, B, true, ctx).
+// Processes up to jump_size steps of the bounds at a time, where the mean measure of each block of steps is at most jump_size.
+// A jump_size of 0 uses tuned_jump_size() of the active window for each block.
+// Within a block, the bottom and top of the window are computed with small convolutions and the middle with
+// a single large convolution followed by rank-one corrections.
+std::vector<double> poisson_process_noncrossing_probability_blocked(int n, double intensity, const std::vector<double>& b, const std::vector<double>& B, int jump_size, ComputationContext& ctx);
+// Same as above with the bounds given as arrays, as used by array_interface.hh.
+std::vector<double> poisson_process_noncrossing_probability_blocked(int n, double intensity, const double* b, int b_size, const double* B, int B_size, int jump_size, ComputationContext& ctx);
+
+// The number of counts at the top of the window that a block of steps with mean measure lambda computes with
+// small convolutions. Paths starting further below are assumed not to reach the top during the block.
+// Also used by the cost model of ecdf_auto.cc.
+int ecdf2_blocked_top_band_depth(double lambda);
+
+#endif
@@ -0,0 +1,174 @@
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ecdf2_reference.hh"
+#include "common.hh"
+#include "sorted_bounds.hh"
+
+using namespace std;
+
+#ifndef CROSSPROB_NO_QUADMATH
+
+extern "C" {
+    #include <quadmath.h>
+}
+#include "builtin_fft.hh"
+
+typedef __float128 QUAD;
+
+template <>
+struct FFTUnitRoot<QUAD> {
+    static complex<QUAD> get(int j, int n)
+    {
+        // M_PIq needs the GNU dialect of C++ for its literal suffix.
+        const QUAD PI = 4*atanq(1);
+        QUAD angle = -2*PI*j/n;
+        return complex<QUAD>(cosq(angle), sinq(angle));
+    }
+};
+
+// Below this size the convolutions are direct, as in FFTWConvolver.
+const int MINIMUM_SIZE_FOR_FFT_CONVOLUTION = 128;
+
+static QUAD poisson_pmf_quad(QUAD lambda, int k)
+{
+    if (lambda == 0) {
+        return (k == 0) ? 1 : 0;
+    }
+    return expq(-lambda + k*logq(lambda) - lgammaq(k+1));
+}
+
+// pmf[k] = Pr[Pois(lambda) = k] for k=0,...,size-1. The mode is computed directly and the other entries by the
+// ratios Pr[k+1]/Pr[k] = lambda/(k+1), whose relative errors add up to about size*1e-34.
+static void poisson_pmf_array_quad(QUAD lambda, int size, vector<QUAD>& pmf)
+{
+    int mode = min(size-1, int(lambda));
+    pmf[mode] = poisson_pmf_quad(lambda, mode);
+    for (int k = mode+1; k < size; ++k) {
+        pmf[k] = pmf[k-1] * lambda / k;
+    }
+    for (int k = mode-1; k >= 0; --k) {
+        pmf[k] = pmf[k+1] * (k+1) / lambda;
+    }
+}
+
+class QuadConvolver {
+public:
+    // dest[k] = sum_{j<=k} src0[j]*src1[k-j] for k=0,...,size-1. dest may be src1.
+    void convolve_same_size(int size, const QUAD* src0, const QUAD* src1, QUAD* dest)
+    {
+        if (size < MINIMUM_SIZE_FOR_FFT_CONVOLUTION) {
+            tmp.assign(size, 0);
+            for (int k = 0; k < size; ++k) {
+                for (int j = 0; j <= k; ++j) {
+                    tmp[k] += src0[j]*src1[k-j];
+                }
+            }
+            copy(tmp.begin(), tmp.end(), dest);
+            return;
+        }
+
+        int padded_size = 1;
+        while (padded_size < 2*size) {
+            padded_size *= 2;
+        }
+        BasicRealFFT<QUAD>& fft = get_fft(padded_size);
+        fft_a.resize(padded_size/2 + 1);
+        fft_b.resize(padded_size/2 + 1);
+        tmp.assign(padded_size, 0);
+        copy(src0, src0+size, tmp.begin());
+        fft.forward(tmp.data(), fft_a.data());
+        fill(tmp.begin(), tmp.end(), QUAD(0));
+        copy(src1, src1+size, tmp.begin());
+        fft.forward(tmp.data(), fft_b.data());
+        for (int k = 0; k <= padded_size/2; ++k) {
+            fft_b[k] *= fft_a[k];
+        }
+        fft.backward(fft_b.data(), tmp.data());
+        for (int k = 0; k < size; ++k) {
+            dest[k] = tmp[k] / padded_size;
+        }
+    }
+
+private:
+    map<int, unique_ptr<BasicRealFFT<QUAD> > > ffts;
+    vector<complex<QUAD> > fft_a;
+    vector<complex<QUAD> > fft_b;
+    vector<QUAD> tmp;
+
+    BasicRealFFT<QUAD>& get_fft(int size)
+    {
+        unique_ptr<BasicRealFFT<QUAD> >& fft = ffts[size];
+        if (!fft) {
+            fft.reset(new BasicRealFFT<QUAD>(size));
+        }
+        return *fft;
+    }
+};
+
+// The sweep of poisson_process_noncrossing_probability() in ecdf2.cc with intensity n, in quad precision.
+static QUAD ecdf2_quad(const vector<double>& b, const vector<double>& B)
+{
+    int n = b.size();
+    check_boundary_vector("b", n, b);
+    check_boundary_vector("B", n, B);
+
+    SortedBounds bounds;
+    join_all_bounds(b, B, vector<double>(), bounds);
+
+    vector<QUAD> state(n+1, 0);
+    state[0] = 1;
+    vector<QUAD> pmf(n+1);
+    QuadConvolver convolver;
+
+    int b_step_count = 0;
+    int B_step_count = 0;
+    QUAD prev_location = 0;
+    for (unsigned int i = 0; i < bounds.size(); ++i) {
+        int cur_size = b_step_count - B_step_count + 1;
+        QUAD lambda = n*(QUAD(bounds.locations[i]) - prev_location);
+        if (lambda > 0) {
+            poisson_pmf_array_quad(lambda, cur_size, pmf);
+            convolver.convolve_same_size(cur_size, pmf.data(), &state[B_step_count], &state[B_step_count]);
+        }
+        if (bounds.tags[i] == bSTEP) {
+            ++b_step_count;
+            state[b_step_count] = 0;
+        } else if (bounds.tags[i] == BSTEP) {
+            state[B_step_count] = 0;
+            ++B_step_count;
+        }
+        prev_location = bounds.locations[i];
+    }
+    return state[n] / poisson_pmf_quad(n, n);
+}
+
+double ecdf2_reference(const vector<double>& b, const vector<double>& B)
+{
+    return double(ecdf2_quad(b, B));
+}
+
+string ecdf2_reference_string(const vector<double>& b, const vector<double>& B)
+{
+    char s[128];
+    quadmath_snprintf(s, sizeof(s), "%.30Qg", ecdf2_quad(b, B));
+    return string(s);
+}
+
+#else
+
+double ecdf2_reference(const vector<double>& b, const vector<double>& B)
+{
+    throw runtime_error("ecdf2_reference() needs libquadmath, but crossprob was built with NO_QUADMATH.");
+}
+
+string ecdf2_reference_string(const vector<double>& b, const vector<double>& B)
+{
+    throw runtime_error("ecdf2_reference() needs libquadmath, but crossprob was built with NO_QUADMATH.");
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef __ecdf2_reference_hh__
+#define __ecdf2_reference_hh__
+
+#include <vector>
+#include <string>
+
+// A reference engine for measuring the accuracy of the fast algorithms. It runs the Poisson recursion of
+// ecdf2(b, B, true) in quadruple precision (__float128, a 113 bit mantissa): the Poisson PMFs, the state and the
+// FFT convolutions, which use BasicRealFFT<__float128> of builtin_fft.hh. The round-off errors are about 1e-30
+// relative to the largest entry of the state, so the result rounded to a double is exact unless it is tiny.
+// The running time is O(n^2 log n) like ecdf2-mn2017, but each quad operation costs about 100 double operations.
+// Requires GCC's libquadmath. When built with "make NO_QUADMATH=1" (e.g. for clang), these throw runtime_error.
+double ecdf2_reference(const std::vector<double>& b, const std::vector<double>& B);
+
+// Same, as a decimal string with 30 significant digits.
+std::string ecdf2_reference_string(const std::vector<double>& b, const std::vector<double>& B);
+
+#endif
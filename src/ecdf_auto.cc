@@ -0,0 +1,224 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+
+#include "ecdf_auto.hh"
+#include "common.hh"
+#include "sorted_bounds.hh"
+#include "jump_size.hh"
+#include "ecdf1_mns2016.hh"
+#include "ecdf1_new.hh"
+#include "ecdf2.hh"
+#include "ecdf2_blocked.hh"
+#include "error_estimate.hh"
+#include "double_double.hh"
+
+using namespace std;
+
+// The cost model below was fit to the running times of the algorithms on the Kolmogorov-Smirnov and Berk-Jones
+// bounds of benchmarks/exactbj.py. Only the ratios between the costs of the algorithms matter.
+
+// Convolution of two arrays of the given size by FFTWConvolver. Below 128 it convolves directly, above it
+// uses FFTs whose size is 2*size rounded up to a multiple of 2048.
+static double convolution_seconds(int size)
+{
+    if (size < 128) {
+        return 1.5e-7 + 8e-9*size;
+    }
+    double fft_size = 2048.0 * ((2*size + 2047) / 2048);
+    return 1.5e-9 * fft_size * log2(fft_size);
+}
+
+// The direct O(size^2) convolution of ecdf2-ks2001.
+static double direct_convolution_seconds(int size)
+{
+    return 8e-9*size + 2.5e-10*size*size;
+}
+
+// The top band of a block of ecdf2-blocked, whose mean measure is about half the jump size.
+static int blocked_band_size(int jump_size)
+{
+    return jump_size + ecdf2_blocked_top_band_depth(0.5*jump_size);
+}
+
+// Cost of one step of ecdf2-blocked whose active window has the given size. A block of k steps does one convolution
+// of the window, and for each step small convolutions of the bands at the bottom and top of the window.
+static double blocked_step_seconds(int window_size)
+{
+    int k = tuned_jump_size(window_size);
+    int band_size = blocked_band_size(k);
+    if ((k == 1) || (window_size <= band_size + k)) {
+        return convolution_seconds(window_size);
+    }
+    return convolution_seconds(window_size)/k + convolution_seconds(band_size) + convolution_seconds(k/2);
+}
+
+// Besides the convolutions, each step of ecdf1-new computes a Poisson PMF and a rank-one correction over the
+// rest of the window, which take about 3 times as long as its share of the large convolution. Fit to the one-sided
+// KS bounds of n=10000: the estimate is 0.14s and the measured time 0.19s, while without the factor it is 0.034s.
+const double ECDF1_NEW_STEP_OVERHEAD_FACTOR = 4.0;
+
+// Same for ecdf1-new, which only has the bottom band.
+static double ecdf1_new_step_seconds(int window_size)
+{
+    int k = tuned_jump_size(window_size);
+    return ECDF1_NEW_STEP_OVERHEAD_FACTOR*(convolution_seconds(window_size)/k + convolution_seconds(k/2));
+}
+
+// Returns the sizes of the active window during the sweep over the bounds, skipping the steps at
+// repeated locations which don't require a convolution.
+static vector<int> window_sizes(const vector<double>& b, const vector<double>& B)
+{
+    SortedBounds bounds;
+    join_all_bounds(b, B, vector<double>(), bounds);
+
+    vector<int> sizes;
+    sizes.reserve(bounds.size());
+    int b_step_count = 0;
+    int B_step_count = 0;
+    double prev_location = 0.0;
+    for (unsigned int i = 0; i < bounds.size(); ++i) {
+        if (bounds.locations[i] > prev_location) {
+            sizes.push_back(b_step_count - B_step_count + 1);
+        }
+        b_step_count += (bounds.tags[i] == bSTEP);
+        B_step_count += (bounds.tags[i] == BSTEP);
+        prev_location = bounds.locations[i];
+    }
+    return sizes;
+}
+
+// Fills in an empty b with zeros and an empty B with ones.
+static void complete_bounds(const vector<double>& b, const vector<double>& B, vector<double>& full_b, vector<double>& full_B)
+{
+    int n = max(b.size(), B.size());
+    if (((int)b.size() != n) && !b.empty()) {
+        throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
+    }
+    if (((int)B.size() != n) && !B.empty()) {
+        throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
+    }
+    full_b = b.empty() ? vector<double>(n, 0.0) : b;
+    full_B = B.empty() ? vector<double>(n, 1.0) : B;
+    check_boundary_vector("b", n, full_b);
+    check_boundary_vector("B", n, full_B);
+}
+
+static bool all_equal(const vector<double>& v, double value)
+{
+    return find_if(v.begin(), v.end(), [value](double x) { return x != value; }) == v.end();
+}
+
+static bool compare_seconds(const AlgorithmEstimate& e0, const AlgorithmEstimate& e1)
+{
+    return e0.seconds < e1.seconds;
+}
+
+vector<AlgorithmEstimate> estimate_running_times(const vector<double>& b, const vector<double>& B)
+{
+    vector<double> full_b, full_B;
+    complete_bounds(b, B, full_b, full_B);
+    double n = full_b.size();
+    bool lower_is_trivial = all_equal(full_b, 0.0);
+    bool upper_is_trivial = all_equal(full_B, 1.0);
+    bool two_sided = !lower_is_trivial && !upper_is_trivial;
+
+    double ks2001 = 0.0;
+    double mn2017 = 0.0;
+    double blocked = 0.0;
+    double ecdf1_new = 0.0;
+    vector<int> sizes = window_sizes(full_b, full_B);
+    for (unsigned int i = 0; i < sizes.size(); ++i) {
+        ks2001 += direct_convolution_seconds(sizes[i]);
+        mn2017 += convolution_seconds(sizes[i]);
+        blocked += blocked_step_seconds(sizes[i]);
+        ecdf1_new += ecdf1_new_step_seconds(sizes[i]);
+    }
+
+    vector<AlgorithmEstimate> estimates;
+    if (!two_sided) {
+        estimates.push_back({"ecdf1-new", ecdf1_new});
+        estimates.push_back({"ecdf1-mns2016", 2.5e-7*n*n});
+    }
+    estimates.push_back({"ecdf2-blocked", blocked});
+    estimates.push_back({"ecdf2-mn2017", mn2017});
+    estimates.push_back({"ecdf2-ks2001", ks2001});
+    stable_sort(estimates.begin(), estimates.end(), compare_seconds);
+    return estimates;
+}
+
+// Below this estimated running time, the slower but more accurate ecdf2-ks2001 is used.
+const double NEGLIGIBLE_SECONDS = 0.001;
+
+// Chooses among the estimates, fastest first, and explains the choice in reason.
+static string choose_algorithm(const vector<AlgorithmEstimate>& estimates, string& reason)
+{
+    for (unsigned int j = 0; j < estimates.size(); ++j) {
+        if ((estimates[j].algorithm == "ecdf2-ks2001") && (estimates[j].seconds < NEGLIGIBLE_SECONDS)) {
+            reason = (j == 0) ? "the fastest estimate" : "its estimated running time is negligible and it has no FFT round-off, although "
+                + estimates[0].algorithm + " is estimated to be faster";
+            return estimates[j].algorithm;
+        }
+    }
+    // ecdf1-mns2016 is never chosen since it loses precision as n grows.
+    for (unsigned int j = 0; j < estimates.size(); ++j) {
+        if (estimates[j].algorithm != "ecdf1-mns2016") {
+            reason = (j == 0) ? "the fastest estimate" : "the fastest estimate except ecdf1-mns2016, which loses precision as n grows";
+            return estimates[j].algorithm;
+        }
+    }
+    throw runtime_error("auto_algorithm(): no algorithm applies to the given boundaries.");
+}
+
+string auto_algorithm(const vector<double>& b, const vector<double>& B)
+{
+    string reason;
+    return choose_algorithm(estimate_running_times(b, B), reason);
+}
+
+string auto_algorithm_reason(const vector<double>& b, const vector<double>& B)
+{
+    string reason;
+    string algorithm = choose_algorithm(estimate_running_times(b, B), reason);
+    return algorithm + ": " + reason;
+}
+
+double ecdf_auto(const vector<double>& b, const vector<double>& B)
+{
+    string algorithm = auto_algorithm(b, B);
+    vector<double> full_b, full_B;
+    complete_bounds(b, B, full_b, full_B);
+
+    if (algorithm == "ecdf2-ks2001") {
+        return ecdf2(full_b, full_B, false);
+    } else if (algorithm == "ecdf2-mn2017") {
+        return ecdf2(full_b, full_B, true);
+    } else if (algorithm == "ecdf2-blocked") {
+        return ecdf2_blocked(full_b, full_B);
+    } else if (all_equal(full_b, 0.0)) {
+        return ecdf1_new_B(full_B);
+    } else {
+        return ecdf1_new_b(full_b);
+    }
+}
+
+AutoResult ecdf_auto_with_tolerance(const vector<double>& b, const vector<double>& B, double tolerance)
+{
+    if (!(tolerance > 0.0)) {
+        throw runtime_error("ecdf_auto_with_tolerance() expects a positive tolerance.");
+    }
+    AutoResult result;
+    ProbabilityWithError with_error = ecdf_with_error("auto", b, B);
+    result.probability = with_error.probability;
+    result.algorithm = auto_algorithm(b, B);
+    result.error_bound = with_error.error_bound;
+    if (with_error.error_bound > tolerance) {
+        vector<double> full_b, full_B;
+        complete_bounds(b, B, full_b, full_B);
+        result.probability = ecdf2_dd(full_b, full_B).noncrossing_probability;
+        result.algorithm = "ecdf2-dd";
+    }
+    return result;
+}
@@ -0,0 +1,45 @@
+#ifndef __ecdf_auto_hh__
+#define __ecdf_auto_hh__
+
+#include <vector>
+#include <string>
+
+// Automatic choice of the algorithm for computing the non-crossing probability of the ECDF.
+// The running time of each applicable algorithm is estimated from n and from the sizes of the active window
+// [B_step_count, b_step_count] during the sweep over the boundaries, which is cheap to compute.
+// As in the crossprob input files, b or B may be empty for one-sided boundaries.
+
+struct AlgorithmEstimate {
+    std::string algorithm;  // Command line name of the algorithm, e.g. "ecdf2-mn2017".
+    double seconds;         // Estimated running time.
+};
+
+// Returns the estimated running times of the algorithms that apply to the boundaries, fastest first.
+// The one-sided algorithms are included if b is all zeros or B is all ones.
+std::vector<AlgorithmEstimate> estimate_running_times(const std::vector<double>& b, const std::vector<double>& B);
+
+// Returns the name of the algorithm used by ecdf_auto().
+// When its estimated running time is negligible, ecdf2-ks2001 is preferred since it has no FFT round-off errors.
+std::string auto_algorithm(const std::vector<double>& b, const std::vector<double>& B);
+
+// The algorithm of auto_algorithm() followed by the reason for choosing it, e.g. "ecdf2-blocked: the fastest estimate".
+std::string auto_algorithm_reason(const std::vector<double>& b, const std::vector<double>& B);
+
+// Computes the non-crossing probability using the algorithm chosen by auto_algorithm().
+double ecdf_auto(const std::vector<double>& b, const std::vector<double>& B);
+
+// The result of ecdf_auto_with_tolerance().
+struct AutoResult {
+    double probability;
+    // The algorithm that computed the probability: that of auto_algorithm(), or "ecdf2-dd".
+    std::string algorithm;
+    // The worst case round-off error bound of the auto_algorithm() computation, see ProbabilityWithError.
+    double error_bound;
+};
+
+// Same as ecdf_auto() for a required precision: the computation is tracked by ecdf_with_error(), and if its worst case
+// error bound exceeds tolerance, the probability is recomputed by ecdf2_dd(), whose errors are about 1e-30.
+// Tolerances below that are not guaranteed to be met. Expects tolerance > 0.
+AutoResult ecdf_auto_with_tolerance(const std::vector<double>& b, const std::vector<double>& B, double tolerance);
+
+#endif
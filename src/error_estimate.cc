@@ -0,0 +1,152 @@
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <stdexcept>
+
+#include "error_estimate.hh"
+#include "common.hh"
+#include "computation_context.hh"
+#include "poisson_pmf.hh"
+#include "ecdf1_new.hh"
+#include "ecdf2.hh"
+#include "ecdf2_blocked.hh"
+#include "ecdf_auto.hh"
+
+using namespace std;
+
+// The unit round-off of doubles.
+const double UNIT_ROUNDOFF = DBL_EPSILON / 2;
+
+// The worst case error of an FFT butterfly relative to its inputs, including the error of the twiddle factors.
+// See Higham (2002), Accuracy and Stability of Numerical Algorithms, section 24.1.
+const double FFT_STAGE_ERROR = 7*UNIT_ROUNDOFF;
+
+// The typical relative error of the Poisson PMF entries, as a fraction of poisson_pmf_relative_error().
+const double TYPICAL_PMF_ERROR_FRACTION = 0.05;
+
+// The errors of the independent model are scaled by this factor. Without it, the estimates of two- and one-sided KS
+// and random bounds at n=2000 and n=4000 were up to 1.7 times below the errors measured by ecdf2_reference(), since
+// part of the error is systematic rather than random. With it they are 2 to 100 times above.
+const double TYPICAL_ERROR_SAFETY_FACTOR = 4.0;
+
+ErrorTracker::ErrorTracker() :
+    relative_bound(0.0), relative_squares(0.0), absolute_bound(0.0), absolute_squares(0.0), fft_convolutions(0), naive_convolutions(0)
+{
+}
+
+void ErrorTracker::add_pmf(double relative_error, double tail_error)
+{
+    relative_bound += relative_error;
+    relative_squares += pow(TYPICAL_PMF_ERROR_FRACTION*relative_error, 2);
+    absolute_bound += tail_error;
+    absolute_squares += pow(tail_error, 2);
+}
+
+void ErrorTracker::add_naive_convolution(int size)
+{
+    // Each entry is a sum of at most size non-negative products.
+    relative_bound += size*UNIT_ROUNDOFF;
+    relative_squares += size*pow(UNIT_ROUNDOFF, 2);
+    ++naive_convolutions;
+}
+
+void ErrorTracker::add_fft_convolution(int padded_size, int size, const double* a, const double* b)
+{
+    double a_l1 = 0.0, a_l2 = 0.0, b_l1 = 0.0, b_l2 = 0.0;
+    for (int i = 0; i < size; ++i) {
+        a_l1 += fabs(a[i]);
+        a_l2 += a[i]*a[i];
+        b_l1 += fabs(b[i]);
+        b_l2 += b[i]*b[i];
+    }
+    a_l2 = sqrt(a_l2);
+    b_l2 = sqrt(b_l2);
+
+    // Each of the three transforms has an error of at most log2(padded_size)*FFT_STAGE_ERROR relative to its output,
+    // in the 2-norm, and the product of a transform with the exact other one is bounded by Young's inequality.
+    // The 2-norm of the whole error vector bounds each entry, whereas random errors spread over its padded_size entries.
+    double stages = log2(double(padded_size));
+    double norms = a_l2*b_l1 + 2*a_l1*b_l2;
+    absolute_bound += (stages*FFT_STAGE_ERROR + UNIT_ROUNDOFF)*norms;
+    absolute_squares += pow(UNIT_ROUNDOFF*norms, 2) * stages / padded_size;
+    ++fft_convolutions;
+}
+
+void ErrorTracker::add_rank_one_correction(double scale, double max_pmf, double pmf_relative_error)
+{
+    double correction = fabs(scale)*max_pmf;
+    absolute_bound += (relative_bound + pmf_relative_error + UNIT_ROUNDOFF)*correction;
+    absolute_squares += pow((sqrt(relative_squares) + TYPICAL_PMF_ERROR_FRACTION*pmf_relative_error)*correction, 2);
+}
+
+void ErrorTracker::add_truncation(double mass)
+{
+    absolute_bound += mass;
+    absolute_squares += mass*mass;
+}
+
+ProbabilityWithError ErrorTracker::result(double state_entry, double pmf, double pmf_relative_error) const
+{
+    ProbabilityWithError r;
+    r.probability = state_entry / pmf;
+    r.error_bound = (relative_bound + pmf_relative_error + UNIT_ROUNDOFF)*fabs(r.probability) + absolute_bound/pmf;
+    double typical_relative = sqrt(relative_squares + pow(TYPICAL_PMF_ERROR_FRACTION*pmf_relative_error, 2));
+    r.error_estimate = TYPICAL_ERROR_SAFETY_FACTOR*(typical_relative*fabs(r.probability) + sqrt(absolute_squares)/pmf);
+    r.error_estimate = min(r.error_estimate, r.error_bound);
+    r.fft_convolutions = fft_convolutions;
+    r.naive_convolutions = naive_convolutions;
+    r.negative_entries = 0;
+    return r;
+}
+
+static bool all_equal(const vector<double>& v, double value)
+{
+    return find_if(v.begin(), v.end(), [value](double x) { return x != value; }) == v.end();
+}
+
+ProbabilityWithError ecdf_with_error(const string& algorithm, const vector<double>& b, const vector<double>& B)
+{
+    int n = max(b.size(), B.size());
+    if ((!b.empty() && ((int)b.size() != n)) || (!B.empty() && ((int)B.size() != n))) {
+        throw runtime_error("Expecting either two boundary lists of length n or one list of length n and one of length zero");
+    }
+    vector<double> full_b = b.empty() ? vector<double>(n, 0.0) : b;
+    vector<double> full_B = B.empty() ? vector<double>(n, 1.0) : B;
+    check_boundary_vector("b", n, full_b);
+    check_boundary_vector("B", n, full_B);
+
+    string name = (algorithm == "auto") ? auto_algorithm(full_b, full_B) : algorithm;
+    ComputationContext ctx(n);
+    ErrorTracker tracker;
+    ctx.set_error_tracker(&tracker);
+
+    // The Poisson recursions of ecdf2(), ecdf2_blocked(), ecdf1_new_B() and ecdf1_new_b().
+    vector<double> state;
+    if ((name == "ecdf2-ks2001") || (name == "ecdf2-mn2017")) {
+        state = poisson_process_noncrossing_probability(n, n, full_b, full_B, name == "ecdf2-mn2017", ctx);
+    } else if (name == "ecdf2-blocked") {
+        state = poisson_process_noncrossing_probability_blocked(n, n, full_b, full_B, 0, ctx);
+    } else if (name == "ecdf1-new") {
+        if (all_equal(full_b, 0.0)) {
+            state = poisson_B_noncrossing_probability_n2(n, n, full_B, 0, ctx);
+        } else if (all_equal(full_B, 1.0)) {
+            vector<double> symmetric_steps(n);
+            for (int i = 0; i < n; ++i) {
+                symmetric_steps[i] = 1.0 - full_b[n-1-i];
+            }
+            state = poisson_B_noncrossing_probability_n2(n, n, symmetric_steps, 0, ctx);
+        } else {
+            state = poisson_process_noncrossing_probability_blocked(n, n, full_b, full_B, 0, ctx);
+        }
+    } else if (name == "ecdf1-mns2016") {
+        throw runtime_error("ecdf_with_error() doesn't support ecdf1-mns2016.");
+    } else {
+        throw runtime_error("Unknown algorithm '" + algorithm + "'. Expecting one of: 'auto', 'ecdf1-new', 'ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked'.");
+    }
+
+    ProbabilityWithError result = tracker.result(state[n], poisson_pmf(n, n), poisson_pmf_relative_error(n, n));
+    result.negative_entries = count_if(state.begin(), state.end(), [](double x) { return x < 0.0; });
+    return result;
+}
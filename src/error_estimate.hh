@@ -0,0 +1,67 @@
+#ifndef __error_estimate_hh__
+#define __error_estimate_hh__
+
+#include <vector>
+#include <string>
+
+// A non-crossing probability with a-posteriori bounds on its round-off error, see ecdf_with_error().
+struct ProbabilityWithError {
+    double probability;
+    // A worst case bound on |probability - exact value|: the worst case round-off of every Poisson PMF, convolution and
+    // rank-one correction of the computation, and the Poisson tails neglected by ecdf2-blocked.
+    double error_bound;
+    // An estimate of the actual size of the same error: the round-off of each operation taken as an independent random
+    // error, scaled up by a safety factor and capped at error_bound. It is usually far smaller than error_bound, but it
+    // is not a bound: for KS and random bounds up to n=4000 it was 2 to 100 times the error measured by ecdf2_reference(),
+    // with the smallest margins at the largest n. Use error_bound to decide whether a more precise computation is needed.
+    double error_estimate;
+    int fft_convolutions;
+    int naive_convolutions;
+    // The number of counts with a negative probability at the end of the Poisson recursion.
+    // Each of these is an error of at most error_bound.
+    int negative_entries;
+};
+
+// Same as the <algorithm> commands of the crossprob tool, returning the error estimates along with the probability.
+// algorithm is one of "auto", "ecdf1-new", "ecdf2-ks2001", "ecdf2-mn2017", "ecdf2-blocked". ecdf1-mns2016 isn't
+// supported since its errors come from its polynomial bases rather than from the operations tracked here.
+// As in the crossprob input files, b or B may be empty for one-sided boundaries.
+// The tracking adds a few percent to the running time.
+ProbabilityWithError ecdf_with_error(const std::string& algorithm, const std::vector<double>& b, const std::vector<double>& B);
+
+// Accumulates the round-off errors of the state vector of a Poisson recursion, when attached to its ComputationContext
+// with set_error_tracker(). The error of each entry s of the state is bounded by relative*s + absolute:
+//     - The Poisson PMFs and the direct convolutions, whose terms are all non-negative, add relative errors.
+//     - The FFT convolutions, the rank-one corrections, which cancel, and the neglected tails add absolute errors.
+// The convolutions with the Poisson PMFs don't amplify the errors, since the PMF entries sum to at most 1.
+// The worst case errors add up, and the typical errors add up in squares.
+class ErrorTracker {
+public:
+    ErrorTracker();
+
+    // A Poisson PMF whose significant entries have a relative error of at most relative_error, and whose other
+    // entries have an absolute error of at most tail_error.
+    void add_pmf(double relative_error, double tail_error);
+    // The direct convolution of two arrays of the given size.
+    void add_naive_convolution(int size);
+    // An FFT convolution of the arrays a and b of the given size, zero padded to padded_size.
+    void add_fft_convolution(int padded_size, int size, const double* a, const double* b);
+    // Subtracting scale times a Poisson PMF whose largest entry is max_pmf and whose entries have a relative error of
+    // at most pmf_relative_error. Since scale is itself a state entry, its relative error becomes an absolute one.
+    void add_rank_one_correction(double scale, double max_pmf, double pmf_relative_error);
+    // Probability mass that was dropped from the state.
+    void add_truncation(double mass);
+
+    // The error of the ratio probability = state_entry / pmf, where the Poisson PMF entry pmf has the given relative error.
+    ProbabilityWithError result(double state_entry, double pmf, double pmf_relative_error) const;
+
+private:
+    double relative_bound;
+    double relative_squares;
+    double absolute_bound;
+    double absolute_squares;
+    int fft_convolutions;
+    int naive_convolutions;
+};
+
+#endif
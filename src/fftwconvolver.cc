@@ -1,8 +1,20 @@
 #include <iostream>
 #include <cassert>
 #include <cstring>
+#include <mutex>
+#include <map>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <atomic>
+#include <cstdlib>
 #include "fftwconvolver.hh"
+#include "builtin_fft.hh"
 #include "aligned_mem.hh"
+#include "profiling.hh"
+#include "error_estimate.hh"
 
 using namespace std;
 
@@ -19,26 +31,141 @@ const int ROUNDING = 2048;
 const int MINIMUM_SIZE_FOR_FFTW_CONVOLUTION = 128;
 
 
+#ifdef CROSSPROB_NO_FFTW
+static const char* FFTW_BACKEND_NAME = NULL;
+#elif defined(CROSSPROB_FFT_MKL)
+static const char* FFTW_BACKEND_NAME = "mkl";
+#else
+static const char* FFTW_BACKEND_NAME = "fftw";
+#endif
+
+// The backend of the convolvers created from now on: 1 for the builtin FFT, 0 for FFTW and -1 if not chosen yet.
+static atomic<int> use_builtin_fft(-1);
+
+vector<string> available_fft_backends()
+{
+    vector<string> names;
+    if (FFTW_BACKEND_NAME != NULL) {
+        names.push_back(FFTW_BACKEND_NAME);
+    }
+    names.push_back("builtin");
+    return names;
+}
+
+void set_fft_backend(const string& name)
+{
+    if ((FFTW_BACKEND_NAME != NULL) && (name == FFTW_BACKEND_NAME)) {
+        use_builtin_fft = 0;
+    } else if (name == "builtin") {
+        use_builtin_fft = 1;
+    } else {
+        vector<string> names = available_fft_backends();
+        stringstream ss;
+        ss << "Unknown FFT backend '" << name << "'. This build supports:";
+        for (unsigned int j = 0; j < names.size(); ++j) {
+            ss << " '" << names[j] << "'";
+        }
+        throw runtime_error(ss.str());
+    }
+}
+
+string get_fft_backend()
+{
+    if (use_builtin_fft < 0) {
+        const char* name = getenv("CROSSPROB_FFT_BACKEND");
+        set_fft_backend(((name != NULL) && (name[0] != '\0')) ? name : available_fft_backends()[0]);
+    }
+    return use_builtin_fft ? "builtin" : FFTW_BACKEND_NAME;
+}
+
+// The size/2+1 coefficients of each column of a batch, rounded up to an even number so that all the columns
+// have the same alignment as the first one, which lets FFTW use SIMD.
+static int batch_column_distance(int size)
+{
+    return 2*((size/2 + 2)/2);
+}
+
+#ifndef CROSSPROB_NO_FFTW
+
+// The plans of all the convolvers, keyed by (size, number of columns, direction, alignment). FFTW's planner is not
+// thread-safe, only fftw_execute*() is, so the registry is only accessed under its lock. Each convolver caches the plans it has
+// looked up and applies them to its own buffers with fftw_execute_dft_*(), so convolvers (one per thread) can be
+// used concurrently. The plans are kept until the end of the process.
+enum PlanDirection {R2C, C2R};
+
+static mutex plan_registry_mutex;
+static map<tuple<int, int, int, int>, fftw_plan> plan_registry;
+
+static fftw_plan registered_plan(int size, int num_columns, PlanDirection direction, double* real, complex<double>* complexes)
+{
+    tuple<int, int, int, int> key(size, num_columns, direction, fftw_alignment_of(real));
+    lock_guard<mutex> lock(plan_registry_mutex);
+    map<tuple<int, int, int, int>, fftw_plan>::const_iterator it = plan_registry.find(key);
+    if (it != plan_registry.end()) {
+        return it->second;
+    }
+    // With FFTW_ESTIMATE the planner doesn't touch the arrays.
+    fftw_plan plan;
+    fftw_complex* fftw_complexes = reinterpret_cast<fftw_complex*>(complexes);
+    if (num_columns == 1) {
+        if (direction == R2C) {
+            plan = fftw_plan_dft_r2c_1d(size, real, fftw_complexes, FFTW_ESTIMATE|FFTW_DESTROY_INPUT);
+        } else {
+            plan = fftw_plan_dft_c2r_1d(size, fftw_complexes, real, FFTW_ESTIMATE|FFTW_DESTROY_INPUT);
+        }
+    } else {
+        // The columns are batch_column_distance(size) complexes apart, see convolve_many().
+        int distance = batch_column_distance(size);
+        if (direction == R2C) {
+            plan = fftw_plan_many_dft_r2c(1, &size, num_columns, real, NULL, 1, 2*distance, fftw_complexes, NULL, 1, distance, FFTW_ESTIMATE|FFTW_DESTROY_INPUT);
+        } else {
+            plan = fftw_plan_many_dft_c2r(1, &size, num_columns, fftw_complexes, NULL, 1, distance, real, NULL, 1, 2*distance, FFTW_ESTIMATE|FFTW_DESTROY_INPUT);
+        }
+    }
+    plan_registry[key] = plan;
+    return plan;
+}
+
+#endif
+
 int round_up(int n, int rounding)
 {
     assert(rounding >= 0);
     return ((n+rounding-1)/rounding)*rounding;
 }
 
+// The builtin FFT only has power of 2 sizes.
+static int next_power_of_2(int n)
+{
+    int power = 1;
+    while (power < n) {
+        power *= 2;
+    }
+    return power;
+}
+
 FFTWConvolver::FFTWConvolver(int maximum_input_size) :
     maximum_input_size(maximum_input_size+ROUNDING-1),
+    error_tracker(NULL),
+    use_builtin(get_fft_backend() == "builtin"),
+#ifndef CROSSPROB_NO_FFTW
     r2c_plans(round_up(2*maximum_input_size, ROUNDING)/ROUNDING, NULL),
-    c2r_plans(round_up(2*maximum_input_size, ROUNDING)/ROUNDING, NULL)
+    c2r_plans(round_up(2*maximum_input_size, ROUNDING)/ROUNDING, NULL),
+#endif
+    batch_capacity(0),
+    batch_a(NULL),
+    batch_b(NULL)
 {
-    int maximum_padded_input_size = round_up(2*maximum_input_size, ROUNDING);
-
-    r2c_in = allocate_aligned_doubles(maximum_padded_input_size);
-    r2c_out = allocate_aligned_complexes(maximum_padded_input_size);
+    // The sizes are checked against this->maximum_input_size, which is what the builtin FFT has to cover.
+    int maximum_padded_input_size = use_builtin ? padded_fft_size(this->maximum_input_size) : round_up(2*maximum_input_size, ROUNDING);
 
-    c2r_in = allocate_aligned_complexes(maximum_padded_input_size);
-    c2r_out = allocate_aligned_doubles(maximum_padded_input_size);
+    fft_a = allocate_aligned_complexes(maximum_padded_input_size/2 + 1);
+    fft_b = allocate_aligned_complexes(maximum_padded_input_size/2 + 1);
+}
 
-    tmp_complex = allocate_aligned_complexes(maximum_padded_input_size);
+int FFTWConvolver::padded_fft_size(int size) const
+{
+    return use_builtin ? next_power_of_2(2*size) : round_up(2*size, ROUNDING);
 }
 
 void convolve_same_size_naive(int size, const double* __restrict__ src0, const double* __restrict__ src1, double* __restrict__ dest)
@@ -53,18 +180,20 @@ void convolve_same_size_naive(int size, const double* __restrict__ src0, const d
     }
 }
 
+// dest <- multiplicative_constant * src * dest, element-wise.
 void elementwise_complex_product(
     int size,
-    const complex<double>* __restrict__ src0,
-    const complex<double>* __restrict__  src1,
+    const complex<double>* __restrict__ src,
     complex<double>* __restrict__ dest,
     double multiplicative_constant)
 {
     for (int i = 0; i < size; ++i) {
-        dest[i] = multiplicative_constant*src0[i]*src1[i];
+        dest[i] = multiplicative_constant*src[i]*dest[i];
     }
 }
 
+#ifndef CROSSPROB_NO_FFTW
+
 fftw_plan FFTWConvolver::memoized_r2c_plan(int rounded_size)
 {
     assert(rounded_size > 0);
@@ -74,7 +203,7 @@ fftw_plan FFTWConvolver::memoized_r2c_plan(int rounded_size)
     assert(index < r2c_plans.size());
 
     if (r2c_plans[index] == NULL) {
-        r2c_plans[index] = fftw_plan_dft_r2c_1d(rounded_size, r2c_in, reinterpret_cast<fftw_complex*>(r2c_out), FFTW_ESTIMATE|FFTW_DESTROY_INPUT);
+        r2c_plans[index] = registered_plan(rounded_size, 1, R2C, reinterpret_cast<double*>(fft_b), fft_b);
     }
 
     return r2c_plans[index];
@@ -89,12 +218,70 @@ fftw_plan FFTWConvolver::memoized_c2r_plan(int rounded_size)
     assert(index < c2r_plans.size());
 
     if (c2r_plans[index] == NULL) {
-        c2r_plans[index] = fftw_plan_dft_c2r_1d(rounded_size, reinterpret_cast<fftw_complex*>(c2r_in), c2r_out, FFTW_ESTIMATE|FFTW_DESTROY_INPUT);
+        c2r_plans[index] = registered_plan(rounded_size, 1, C2R, reinterpret_cast<double*>(fft_b), fft_b);
     }
 
     return c2r_plans[index];
 }
 
+fftw_plan FFTWConvolver::memoized_batch_plan(int rounded_size, int num_columns, int direction)
+{
+    tuple<int, int, int> key(rounded_size, num_columns, direction);
+    map<tuple<int, int, int>, fftw_plan>::const_iterator it = batch_plans.find(key);
+    if (it != batch_plans.end()) {
+        return it->second;
+    }
+    fftw_plan plan = registered_plan(rounded_size, num_columns, PlanDirection(direction), reinterpret_cast<double*>(batch_b), batch_b);
+    batch_plans[key] = plan;
+    return plan;
+}
+
+#endif
+
+BuiltinRealFFT& FFTWConvolver::builtin_fft(int padded_size)
+{
+    map<int, BuiltinRealFFT*>::const_iterator it = builtin_ffts.find(padded_size);
+    if (it != builtin_ffts.end()) {
+        return *it->second;
+    }
+    BuiltinRealFFT* fft = new BuiltinRealFFT(padded_size);
+    builtin_ffts[padded_size] = fft;
+    return *fft;
+}
+
+// The columns are batch_column_distance(padded_size) complexes apart, a single column may be anywhere.
+void FFTWConvolver::forward_fft(int padded_size, int num_columns, complex<double>* columns)
+{
+#ifndef CROSSPROB_NO_FFTW
+    if (!use_builtin) {
+        fftw_plan plan = (num_columns == 1) ? memoized_r2c_plan(padded_size) : memoized_batch_plan(padded_size, num_columns, R2C);
+        fftw_execute_dft_r2c(plan, reinterpret_cast<double*>(columns), reinterpret_cast<fftw_complex*>(columns));
+        return;
+    }
+#endif
+    BuiltinRealFFT& fft = builtin_fft(padded_size);
+    int distance = batch_column_distance(padded_size);
+    for (int c = 0; c < num_columns; ++c) {
+        fft.forward(reinterpret_cast<double*>(&columns[c*distance]), &columns[c*distance]);
+    }
+}
+
+void FFTWConvolver::backward_fft(int padded_size, int num_columns, complex<double>* columns)
+{
+#ifndef CROSSPROB_NO_FFTW
+    if (!use_builtin) {
+        fftw_plan plan = (num_columns == 1) ? memoized_c2r_plan(padded_size) : memoized_batch_plan(padded_size, num_columns, C2R);
+        fftw_execute_dft_c2r(plan, reinterpret_cast<fftw_complex*>(columns), reinterpret_cast<double*>(columns));
+        return;
+    }
+#endif
+    BuiltinRealFFT& fft = builtin_fft(padded_size);
+    int distance = batch_column_distance(padded_size);
+    for (int c = 0; c < num_columns; ++c) {
+        fft.backward(&columns[c*distance], reinterpret_cast<double*>(&columns[c*distance]));
+    }
+}
+
 template<class T>
 void copy_zero_padded(const T* src, T* dest, int src_size, int dest_size)
 {
@@ -118,50 +305,148 @@ void FFTWConvolver::convolve_same_size(
     }
 
     if (size < MINIMUM_SIZE_FOR_FFTW_CONVOLUTION) {
+        PROFILE_PHASE(PHASE_NAIVE_CONVOLUTION);
+        PROFILE_CONVOLUTION(false, size, size);
         convolve_same_size_naive(size, input_a, input_b, output);
+        if (error_tracker != NULL) {
+            error_tracker->add_naive_convolution(size);
+        }
         return;
     }
 
-    int padded_size = round_up(2*size, ROUNDING);
+    int padded_size = padded_fft_size(size);
+    PROFILE_PHASE(PHASE_FFT_CONVOLUTION);
+    PROFILE_CONVOLUTION(true, size, padded_size);
+    if (error_tracker != NULL) {
+        error_tracker->add_fft_convolution(padded_size, size, input_a, input_b);
+    }
     
-    // tmp_complex <- FFT(zeropad(input_a));
-    copy_zero_padded(input_a, r2c_in, size, padded_size);
-    //fftw_execute(memoized_r2c_plan(padded_size));
-    //memcpy(tmp_complex, r2c_out, sizeof(complex<double>)*(padded_size/2 + 1));
-    fftw_execute_dft_r2c(memoized_r2c_plan(padded_size), r2c_in, reinterpret_cast<fftw_complex*>(tmp_complex));
-    // Try this instead of last two lines:
-    // fftw_execute_dft_r2c(memoized_r2c_plan(padded_length), r2c_in, tmp_complex);
-
-    // r2c_out <- FFT(zeropad(input_b));
-    copy_zero_padded(input_b, r2c_in, size, padded_size); 
-    fftw_execute(memoized_r2c_plan(padded_size));
+    // fft_a <- FFT(zeropad(input_a));
+    double* real_a = reinterpret_cast<double*>(fft_a);
+    copy_zero_padded(input_a, real_a, size, padded_size);
+    forward_fft(padded_size, 1, fft_a);
+
+    // fft_b <- FFT(zeropad(input_b));
+    double* real_b = reinterpret_cast<double*>(fft_b);
+    copy_zero_padded(input_b, real_b, size, padded_size);
+    forward_fft(padded_size, 1, fft_b);
 
     // Perform element-wise product of FFT(a) and FFT(b) and then compute inverse fourier transform.
     // FFTW returns unnormalized output. To normalize it one must divide each element of the result by the number of elements.
-    elementwise_complex_product(padded_size/2 + 1, tmp_complex, r2c_out, c2r_in, 1.0/double(padded_size));
-    fftw_execute(memoized_c2r_plan(padded_size));
-    std::memcpy(output, c2r_out, size * sizeof(double));
+    elementwise_complex_product(padded_size/2 + 1, fft_a, fft_b, 1.0/double(padded_size));
+    backward_fft(padded_size, 1, fft_b);
+    std::memcpy(output, real_b, size * sizeof(double));
 }
 
-FFTWConvolver::~FFTWConvolver()
+void FFTWConvolver::reserve_batch(int num_complexes)
 {
-    for (size_t i = 0; i < r2c_plans.size(); ++i) {
-        if (r2c_plans[i] != NULL) {
-            fftw_destroy_plan(r2c_plans[i]);
-        }
+    if (num_complexes <= batch_capacity) {
+        return;
+    }
+    if (batch_a != NULL) {
+        free_aligned_mem(batch_a);
+        free_aligned_mem(batch_b);
     }
+    batch_a = allocate_aligned_complexes(num_complexes);
+    batch_b = allocate_aligned_complexes(num_complexes);
+    batch_capacity = num_complexes;
+#ifndef CROSSPROB_NO_FFTW
+    // The cached plans were looked up for the alignment of the previous buffers.
+    batch_plans.clear();
+#endif
+}
 
-    for (size_t i = 0; i < c2r_plans.size(); ++i) {
-        if (c2r_plans[i] != NULL) {
-            fftw_destroy_plan(c2r_plans[i]);
+void FFTWConvolver::convolve_many(int num_columns, const int* sizes, const double* kernel, const double* const* inputs, double* const* outputs)
+{
+    vector<const double*> kernels(num_columns, kernel);
+    convolve_many(num_columns, sizes, kernels.data(), inputs, outputs);
+}
+
+void FFTWConvolver::convolve_many(int num_columns, const int* sizes, const double* const* kernels, const double* const* inputs, double* const* outputs)
+{
+    // The small columns are convolved directly, the others are ordered by FFT size.
+    batch_order.clear();
+    for (int j = 0; j < num_columns; ++j) {
+        if (sizes[j] > maximum_input_size) {
+            stringstream ss;
+            ss << "FFTWConvolver::convolve_many received input of size " << sizes[j] << ". This is bigger than maximum_input_size==" << maximum_input_size;
+            throw runtime_error(ss.str());
+        }
+        if (sizes[j] >= MINIMUM_SIZE_FOR_FFTW_CONVOLUTION) {
+            batch_order.push_back(j);
+        } else if (sizes[j] > 0) {
+            PROFILE_PHASE(PHASE_NAIVE_CONVOLUTION);
+            PROFILE_CONVOLUTION(false, sizes[j], sizes[j]);
+            // Through fft_b, since the output may be the input.
+            double* real_b = reinterpret_cast<double*>(fft_b);
+            convolve_same_size_naive(sizes[j], kernels[j], inputs[j], real_b);
+            std::memcpy(outputs[j], real_b, sizes[j] * sizeof(double));
+            if (error_tracker != NULL) {
+                error_tracker->add_naive_convolution(sizes[j]);
+            }
         }
     }
+    stable_sort(batch_order.begin(), batch_order.end(), [this, sizes](int j0, int j1) { return padded_fft_size(sizes[j0]) < padded_fft_size(sizes[j1]); });
+
+    unsigned int batch_start = 0;
+    while (batch_start < batch_order.size()) {
+        int padded_size = padded_fft_size(sizes[batch_order[batch_start]]);
+        unsigned int batch_end = batch_start;
+        int max_size = 0;
+        bool shared_kernel = true;
+        while ((batch_end < batch_order.size()) && (padded_fft_size(sizes[batch_order[batch_end]]) == padded_size)) {
+            int j = batch_order[batch_end++];
+            max_size = max(max_size, sizes[j]);
+            shared_kernel = shared_kernel && (kernels[j] == kernels[batch_order[batch_start]]);
+        }
+        int batch_size = batch_end - batch_start;
+        int distance = batch_column_distance(padded_size);
+        reserve_batch(batch_size*distance);
+        PROFILE_PHASE(PHASE_FFT_CONVOLUTION);
+
+        // batch_b <- FFT(zeropad(inputs)), and the same for the kernels in batch_a or, if shared, once in fft_a.
+        for (int c = 0; c < batch_size; ++c) {
+            int j = batch_order[batch_start+c];
+            PROFILE_CONVOLUTION(true, sizes[j], padded_size);
+            if (error_tracker != NULL) {
+                error_tracker->add_fft_convolution(padded_size, sizes[j], kernels[j], inputs[j]);
+            }
+            copy_zero_padded(inputs[j], reinterpret_cast<double*>(&batch_b[c*distance]), sizes[j], padded_size);
+            if (!shared_kernel) {
+                copy_zero_padded(kernels[j], reinterpret_cast<double*>(&batch_a[c*distance]), sizes[j], padded_size);
+            }
+        }
+        forward_fft(padded_size, batch_size, batch_b);
+        if (shared_kernel) {
+            double* real_a = reinterpret_cast<double*>(fft_a);
+            copy_zero_padded(kernels[batch_order[batch_start]], real_a, max_size, padded_size);
+            forward_fft(padded_size, 1, fft_a);
+        } else {
+            forward_fft(padded_size, batch_size, batch_a);
+        }
 
-    free_aligned_mem(r2c_in);
-    free_aligned_mem(r2c_out);
-
-    free_aligned_mem(c2r_in);
-    free_aligned_mem(c2r_out);
+        for (int c = 0; c < batch_size; ++c) {
+            const complex<double>* fft_kernel = shared_kernel ? fft_a : &batch_a[c*distance];
+            elementwise_complex_product(padded_size/2 + 1, fft_kernel, &batch_b[c*distance], 1.0/double(padded_size));
+        }
+        backward_fft(padded_size, batch_size, batch_b);
+        for (int c = 0; c < batch_size; ++c) {
+            int j = batch_order[batch_start+c];
+            std::memcpy(outputs[j], &batch_b[c*distance], sizes[j] * sizeof(double));
+        }
+        batch_start = batch_end;
+    }
+}
 
-    free_aligned_mem(tmp_complex);
+FFTWConvolver::~FFTWConvolver()
+{
+    free_aligned_mem(fft_a);
+    free_aligned_mem(fft_b);
+    if (batch_a != NULL) {
+        free_aligned_mem(batch_a);
+        free_aligned_mem(batch_b);
+    }
+    for (map<int, BuiltinRealFFT*>::iterator it = builtin_ffts.begin(); it != builtin_ffts.end(); ++it) {
+        delete it->second;
+    }
 }
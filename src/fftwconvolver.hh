@@ -2,32 +2,88 @@
 #define __fftwconvolver_hh__
 
 #include <vector>
+#include <string>
 #include <complex>
+#include <map>
+#include <tuple>
+#ifndef CROSSPROB_NO_FFTW
 #include <fftw3.h>
+#endif
+
+template <typename T> class BasicRealFFT;
+typedef BasicRealFFT<double> BuiltinRealFFT;
+class ErrorTracker;
+
+// The FFT backends of the convolvers:
+//     "fftw": FFTW 3, the default. Reported as "mkl" when built against MKL's FFTW interface ("make FFT=mkl").
+//     "builtin": a split-radix FFT of power of 2 sizes in builtin_fft.hh. The only one when built with "make FFT=builtin".
+// The first call of get_fft_backend() takes the default from the environment variable CROSSPROB_FFT_BACKEND.
+// Changing the backend only affects the convolvers created afterwards.
+std::vector<std::string> available_fft_backends();
+void set_fft_backend(const std::string& name);
+std::string get_fft_backend();
+
+// The direct O(size^2) convolution used by FFTWConvolver for small sizes.
+void convolve_same_size_naive(int size, const double* src0, const double* src1, double* dest);
 
 class FFTWConvolver {
 public:
     FFTWConvolver(int maximum_input_size);
     ~FFTWConvolver();
     void convolve_same_size(int size, const double* input_a, const double* input_b, double* output);
+
+    // Convolves num_columns pairs of arrays: outputs[j] gets the first sizes[j] entries of the convolution of
+    // kernels[j] and inputs[j], both of size sizes[j]. Same as calling convolve_same_size() for each j, but the columns
+    // whose FFTs have the same size are transformed together by batched plans (fftw_plan_many_dft_*()).
+    // If all the kernels of a batch are the same pointer, it is transformed only once. The outputs may be the inputs.
+    void convolve_many(int num_columns, const int* sizes, const double* const* kernels, const double* const* inputs, double* const* outputs);
+    // Same with a single kernel for all the columns, which must have max(sizes) entries.
+    void convolve_many(int num_columns, const int* sizes, const double* kernel, const double* const* inputs, double* const* outputs);
+
+    // Reports the round-off errors of the convolutions to tracker, if not NULL.
+    void set_error_tracker(ErrorTracker* tracker) { error_tracker = tracker; }
 private:
     int maximum_input_size;
+    ErrorTracker* error_tracker;
+    // The backend at construction.
+    bool use_builtin;
+    // The FFT size used for inputs of the given size: 2*size rounded up to a multiple of 2048 for FFTW and to a
+    // power of 2 for the builtin FFT.
+    int padded_fft_size(int size) const;
 
-    std::complex<double>* tmp_complex;
+    // The transforms are done in place, each buffer holds the padded_size/2+1 complex coefficients of one input.
+    std::complex<double>* fft_a;
+    std::complex<double>* fft_b;
 
+    // In place transforms of num_columns columns with the current backend, the layout of the columns is that of
+    // batch_a and batch_b below.
+    void forward_fft(int padded_size, int num_columns, std::complex<double>* columns);
+    void backward_fft(int padded_size, int num_columns, std::complex<double>* columns);
+    std::map<int, BuiltinRealFFT*> builtin_ffts;
+    BuiltinRealFFT& builtin_fft(int padded_size);
 
-    // The r2c plans perform, for various sizes, a real to complex FFT with input at r2c_in and output at r2c_out
-    double* r2c_in;
-    std::complex<double>* r2c_out;
+#ifndef CROSSPROB_NO_FFTW
+    // The in place real to complex and complex to real plans for various sizes. These are looked up in the plan
+    // registry of fftwconvolver.cc, which is shared by all the convolvers, and applied with fftw_execute_dft_*().
     std::vector<fftw_plan> r2c_plans;
     fftw_plan memoized_r2c_plan(int rounded_size);
-
-    // The c2r plans perform, for various sizes, a complex to real FFT with input at c2r_in and output at c2r_out
-    std::complex<double>* c2r_in;
-    double* c2r_out;
     std::vector<fftw_plan> c2r_plans;
     fftw_plan memoized_c2r_plan(int rounded_size);
+#endif
 
+    // The buffers of convolve_many(), column j of a batch of FFT size P starts at entry j*(P/2+2) and is transformed
+    // in place. These grow to the largest batch seen.
+    int batch_capacity;
+    std::complex<double>* batch_a;
+    std::complex<double>* batch_b;
+    void reserve_batch(int num_complexes);
+#ifndef CROSSPROB_NO_FFTW
+    // The batched plans by (rounded_size, num_columns, direction), cached like r2c_plans and c2r_plans.
+    std::map<std::tuple<int, int, int>, fftw_plan> batch_plans;
+    fftw_plan memoized_batch_plan(int rounded_size, int num_columns, int direction);
+#endif
+    // The columns of convolve_many() ordered by FFT size.
+    std::vector<int> batch_order;
 };
 
 #endif
@@ -0,0 +1,233 @@
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+
+#include "jump_size.hh"
+#include "fftwconvolver.hh"
+#include "poisson_pmf.hh"
+
+using namespace std;
+
+// Window sizes are calibrated on a geometric grid with this ratio.
+const double CALIBRATION_GRID_RATIO = 1.1;
+// Each measurement is repeated for at least this long.
+const double MINIMUM_MEASUREMENT_SECONDS = 0.002;
+
+// The calibration table is loaded lazily and may be replaced by load_jump_size_calibration(), under calibration_mutex.
+static mutex calibration_mutex;
+static vector<int> calibration_window_sizes;
+static vector<int> calibration_jump_sizes;
+static bool calibration_loaded = false;
+static atomic<int> fixed_jump_size(0);
+
+string default_jump_size_calibration_filename()
+{
+    const char* filename = getenv("CROSSPROB_CALIBRATION_FILE");
+    if (filename != NULL) {
+        return filename;
+    }
+    const char* home = getenv("HOME");
+    return string((home != NULL) ? home : ".") + "/.crossprob_calibration";
+}
+
+static void read_calibration_file(ifstream& f, const string& filename, vector<int>& window_sizes, vector<int>& jump_sizes)
+{
+    string line;
+    while (getline(f, line)) {
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
+        stringstream ss(line);
+        int window_size, jump_size;
+        if (!(ss >> window_size >> jump_size) || (window_size <= 0) || (jump_size <= 0) || (!window_sizes.empty() && (window_size <= window_sizes.back()))) {
+            throw runtime_error("Invalid line '" + line + "' in the jump size calibration file '" + filename + "'");
+        }
+        window_sizes.push_back(window_size);
+        jump_sizes.push_back(jump_size);
+    }
+}
+
+void load_jump_size_calibration(const string& filename)
+{
+    ifstream f(filename);
+    if (!f.is_open()) {
+        throw runtime_error("Unable to read the jump size calibration file '" + filename + "'");
+    }
+    vector<int> window_sizes, jump_sizes;
+    read_calibration_file(f, filename, window_sizes, jump_sizes);
+    lock_guard<mutex> lock(calibration_mutex);
+    calibration_window_sizes.swap(window_sizes);
+    calibration_jump_sizes.swap(jump_sizes);
+    calibration_loaded = true;
+}
+
+// Without a calibration file the default rule is used. Called under calibration_mutex. A corrupt file leaves
+// the table empty and unloaded, so that every call reports it rather than using part of it.
+static void load_default_calibration()
+{
+    string filename = default_jump_size_calibration_filename();
+    ifstream f(filename);
+    vector<int> window_sizes, jump_sizes;
+    if (f.is_open()) {
+        read_calibration_file(f, filename, window_sizes, jump_sizes);
+    }
+    calibration_window_sizes.swap(window_sizes);
+    calibration_jump_sizes.swap(jump_sizes);
+    calibration_loaded = true;
+}
+
+int tuned_jump_size(int window_size)
+{
+    window_size = max(window_size, 1);
+    int jump_size = fixed_jump_size;
+    if (jump_size > 0) {
+        return min(jump_size, window_size);
+    }
+    lock_guard<mutex> lock(calibration_mutex);
+    if (!calibration_loaded) {
+        load_default_calibration();
+    }
+
+    if (calibration_window_sizes.empty() || (window_size < calibration_window_sizes.front())) {
+        // Asymptotically any k in the range [logn, n/logn] should give optimal results as n goes to infinity.
+        // Setting k=c*sqrt(n) and minimizing the asymptotic runtime, we obtain k=sqrt(2*n),
+        // however, empirically slightly lower numbers give better results.
+        jump_size = int(sqrt(window_size)) + 1;
+    } else {
+        int i = upper_bound(calibration_window_sizes.begin(), calibration_window_sizes.end(), window_size) - calibration_window_sizes.begin() - 1;
+        jump_size = calibration_jump_sizes[i];
+        if (i == (int)calibration_window_sizes.size()-1) {
+            // Beyond the table, the best jump size grows like sqrt(window_size).
+            jump_size = int(jump_size * sqrt(double(window_size) / calibration_window_sizes[i]));
+        }
+    }
+    return max(1, min(jump_size, window_size));
+}
+
+void set_jump_size(int jump_size)
+{
+    if (jump_size < 0) {
+        throw runtime_error("Expecting a non-negative jump size (0 means automatic).");
+    }
+    fixed_jump_size = jump_size;
+}
+
+int get_jump_size()
+{
+    return fixed_jump_size;
+}
+
+// Returns the fastest running time of f() in seconds.
+template<class F>
+static double measure_seconds(F f)
+{
+    double best = 1e100;
+    for (int rep = 0; rep < 3; ++rep) {
+        int calls = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        double elapsed;
+        do {
+            f();
+            ++calls;
+            elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        } while (elapsed < MINIMUM_MEASUREMENT_SECONDS);
+        best = min(best, elapsed / calls);
+    }
+    return best;
+}
+
+// Measures f(size) on a geometric grid of sizes and linearly interpolates it to all sizes 0,...,max_size.
+template<class F>
+static vector<double> measure_costs(int max_size, F f)
+{
+    vector<int> grid;
+    for (double s = 1.0; int(s) < max_size; s = max(s+1.0, s*CALIBRATION_GRID_RATIO)) {
+        grid.push_back(int(s));
+    }
+    grid.push_back(max_size);
+
+    vector<double> grid_costs(grid.size());
+    for (unsigned int j = 0; j < grid.size(); ++j) {
+        grid_costs[j] = measure_seconds([&]() { f(grid[j]); });
+    }
+
+    vector<double> costs(max_size+1, 0.0);
+    for (unsigned int j = 0; j+1 < grid.size(); ++j) {
+        for (int s = grid[j]; s <= grid[j+1]; ++s) {
+            double fraction = double(s - grid[j]) / (grid[j+1] - grid[j]);
+            costs[s] = grid_costs[j] + fraction*(grid_costs[j+1] - grid_costs[j]);
+        }
+    }
+    costs[max_size] = grid_costs.back();
+    return costs;
+}
+
+// A block of poisson_B_noncrossing_probability_n2() with jump size k and active window w computes the PMF and a
+// convolution of size w, then one PMF and convolution of each of the sizes k,k-1,...,2, each followed by a rank-one correction.
+// The jump size minimizing the cost per step is chosen for each window size.
+vector<int> calibrate_jump_size(const string& filename, int max_window_size)
+{
+    if (max_window_size < 2) {
+        throw runtime_error("Expecting a maximum window size of at least 2 for the jump size calibration.");
+    }
+    FFTWConvolver fftconvolver(max_window_size);
+    PoissonPMFGenerator pmfgen(max_window_size);
+    vector<double> src(max_window_size, 0.0);
+    vector<double> dest(max_window_size, 0.0);
+
+    vector<double> convolution_costs = measure_costs(max_window_size, [&](int size) {
+        pmfgen.compute_array(size, 0.5*size);
+        fftconvolver.convolve_same_size(size, pmfgen.get_array(), &src[0], &dest[0]);
+    });
+    vector<double> correction_costs = measure_costs(max_window_size, [&](int k) {
+        pmfgen.subtract_scaled_pmf(1e-3, 0.5*k, 1, max_window_size-1, &dest[0]);
+    });
+
+    vector<double> cumulative_convolution_costs(max_window_size+1, 0.0);
+    for (int s = 2; s <= max_window_size; ++s) {
+        cumulative_convolution_costs[s] = cumulative_convolution_costs[s-1] + convolution_costs[s];
+    }
+
+    vector<int> window_sizes, jump_sizes;
+    for (double w = 16.0; int(w) <= max_window_size; w *= CALIBRATION_GRID_RATIO) {
+        int window_size = int(w);
+        int best_jump_size = 1;
+        double best_cost = 1e100;
+        for (int k = 1; k <= window_size; ++k) {
+            double cost = (convolution_costs[window_size] + cumulative_convolution_costs[k] + (k-1)*correction_costs[k]) / k;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_jump_size = k;
+            }
+        }
+        if (window_sizes.empty() || (window_size > window_sizes.back())) {
+            window_sizes.push_back(window_size);
+            jump_sizes.push_back(best_jump_size);
+        }
+    }
+
+    ofstream f(filename);
+    if (!f.is_open()) {
+        throw runtime_error("Unable to write the jump size calibration file '" + filename + "'");
+    }
+    f << "# crossprob jump size calibration: <window-size> <jump-size>\n";
+    vector<int> table;
+    for (unsigned int j = 0; j < window_sizes.size(); ++j) {
+        f << window_sizes[j] << " " << jump_sizes[j] << "\n";
+        table.push_back(window_sizes[j]);
+        table.push_back(jump_sizes[j]);
+    }
+
+    lock_guard<mutex> lock(calibration_mutex);
+    calibration_window_sizes.swap(window_sizes);
+    calibration_jump_sizes.swap(jump_sizes);
+    calibration_loaded = true;
+    return table;
+}
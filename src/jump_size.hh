@@ -0,0 +1,34 @@
+#ifndef __jump_size_hh__
+#define __jump_size_hh__
+
+#include <string>
+#include <vector>
+
+// The jump size of ecdf1_new is the number of boundary steps processed with each large FFT convolution.
+// Its best value balances one large convolution of the active window against jump_size small convolutions,
+// so it depends on the window size and on the relative speed of FFT and naive convolutions on the machine.
+//
+// By default the jump size is sqrt(window_size)+1. A calibration table of the best jump size for various
+// window sizes can be measured once per machine and saved to a file, which is loaded on first use from
+// $CROSSPROB_CALIBRATION_FILE or else from $HOME/.crossprob_calibration.
+
+// Returns the jump size for a block of steps whose active window has the given size,
+// or the value of set_jump_size() if it was called with a positive value.
+int tuned_jump_size(int window_size);
+
+// Uses a fixed jump size for all the subsequent computations. A jump_size of 0 restores the automatic choice.
+void set_jump_size(int jump_size);
+int get_jump_size();
+
+// Measures the convolution costs of the current machine for window sizes up to max_window_size,
+// uses the resulting table for the subsequent computations and writes it to filename.
+// Returns the table as a flat list window_size_0, jump_size_0, window_size_1, jump_size_1, ...
+std::vector<int> calibrate_jump_size(const std::string& filename, int max_window_size);
+
+// Replaces the current calibration table with the one in the given file.
+void load_jump_size_calibration(const std::string& filename);
+
+// $CROSSPROB_CALIBRATION_FILE if it is set, otherwise $HOME/.crossprob_calibration.
+std::string default_jump_size_calibration_filename();
+
+#endif
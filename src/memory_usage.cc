@@ -0,0 +1,31 @@
+#include <atomic>
+
+#include "memory_usage.hh"
+
+using namespace std;
+
+static atomic<long> current_bytes(0);
+static atomic<long> peak_bytes(0);
+
+void add_allocated_bytes(long bytes)
+{
+    long current = (current_bytes += bytes);
+    long peak = peak_bytes.load();
+    while ((current > peak) && !peak_bytes.compare_exchange_weak(peak, current)) {
+    }
+}
+
+long allocated_bytes()
+{
+    return current_bytes.load();
+}
+
+long peak_allocated_bytes()
+{
+    return peak_bytes.load();
+}
+
+void reset_peak_allocated_bytes()
+{
+    peak_bytes = current_bytes.load();
+}
@@ -0,0 +1,31 @@
+#ifndef __memory_usage_hh__
+#define __memory_usage_hh__
+
+// Accounting of the memory of the large buffers: the FFT buffers, Poisson PMF tables and other arrays allocated by
+// allocate_aligned_doubles() and allocate_aligned_complexes(), and the probability vectors of the sweeps, which
+// register themselves with a ScopedAllocation. The sorted bounds (12 bytes per boundary step) are not counted.
+// The counters are updated atomically.
+
+void add_allocated_bytes(long bytes);
+
+// The number of bytes currently allocated.
+long allocated_bytes();
+
+// The maximum of allocated_bytes() since the last call to reset_peak_allocated_bytes().
+long peak_allocated_bytes();
+
+// Sets the peak to the current number of allocated bytes.
+void reset_peak_allocated_bytes();
+
+// Counts the given number of bytes as allocated during the lifetime of the object.
+class ScopedAllocation {
+public:
+    ScopedAllocation(long bytes) : bytes(bytes) { add_allocated_bytes(bytes); }
+    ~ScopedAllocation() { add_allocated_bytes(-bytes); }
+private:
+    long bytes;
+    ScopedAllocation(const ScopedAllocation&);
+    ScopedAllocation& operator=(const ScopedAllocation&);
+};
+
+#endif
@@ -4,10 +4,12 @@
 #include <iostream>
 #include "poisson_pmf.hh"
 #include "aligned_mem.hh"
+#include "profiling.hh"
+#include "error_estimate.hh"
 
 using namespace std;
 
-PoissonPMFGenerator::PoissonPMFGenerator(int max_k)
+PoissonPMFGenerator::PoissonPMFGenerator(int max_k) : error_tracker(NULL)
 {
     assert(max_k > 0);
 
@@ -31,6 +33,7 @@ PoissonPMFGenerator::~PoissonPMFGenerator()
 
 void PoissonPMFGenerator::compute_array(int k, double lambda)
 {
+    PROFILE_PHASE(PHASE_PMF);
     assert(k >= 0);
     assert(k <= max_k);
 
@@ -49,5 +52,77 @@ void PoissonPMFGenerator::compute_array(int k, double lambda)
     for (int i = 0; i < k+1; ++i) {
         pmf_array_ptr[i] = exp(-lambda + i*log_lambda - log_gamma_LUT[i+1]);
     }
+
+    if (error_tracker != NULL) {
+        // The entries below DBL_EPSILON times the largest one only matter through their absolute errors.
+        double max_pmf = *max_element(pmf_array_ptr, pmf_array_ptr+k+1);
+        int last_significant = k;
+        while (pmf_array_ptr[last_significant] < DBL_EPSILON*max_pmf) {
+            --last_significant;
+        }
+        error_tracker->add_pmf(poisson_pmf_relative_error(lambda, last_significant), poisson_pmf_relative_error(lambda, k)*DBL_EPSILON*max_pmf);
+    }
 }
 
+// Below this, exp() is subnormal (flushed to zero with -ffast-math).
+const double LOG_PMF_UNDERFLOW = -708.0;
+
+void PoissonPMFGenerator::subtract_scaled_pmf(double scale, double lambda, int k_start, int count, double* __restrict__ dest) const
+{
+    PROFILE_PHASE(PHASE_RANK_ONE_CORRECTION);
+    assert(k_start >= 0);
+    assert(k_start+count <= max_k+1);
+
+    if ((scale == 0) || (count <= 0)) {
+        return;
+    }
+    if (lambda == 0) {
+        if (k_start == 0) {
+            dest[0] -= scale;
+            if (error_tracker != NULL) {
+                error_tracker->add_rank_one_correction(scale, 1.0, 0.0);
+            }
+        }
+        return;
+    }
+
+    // The log of the PMF is concave in k, so it is above LOG_PMF_UNDERFLOW on an interval [low, high] around the mode.
+    // Typically this interval is much shorter than count, and skipping the rest is the main saving.
+    double log_lambda = log(lambda);
+    int k_end = k_start + count - 1;
+    int mode = max(k_start, min(k_end, int(lambda)));
+    if (-lambda + mode*log_lambda - log_gamma_LUT[mode+1] < LOG_PMF_UNDERFLOW) {
+        return;
+    }
+    int low = k_start;
+    int high = mode;
+    while (low < high) {
+        int mid = low + (high-low)/2;
+        if (-lambda + mid*log_lambda - log_gamma_LUT[mid+1] < LOG_PMF_UNDERFLOW) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    int first = low;
+    low = mode;
+    high = k_end;
+    while (low < high) {
+        int mid = high - (high-low)/2;
+        if (-lambda + mid*log_lambda - log_gamma_LUT[mid+1] < LOG_PMF_UNDERFLOW) {
+            high = mid - 1;
+        } else {
+            low = mid;
+        }
+    }
+    int last = low;
+    if (error_tracker != NULL) {
+        double max_pmf = exp(-lambda + mode*log_lambda - log_gamma_LUT[mode+1]);
+        error_tracker->add_rank_one_correction(scale, max_pmf, poisson_pmf_relative_error(lambda, last));
+    }
+
+    const double* __restrict__ log_gamma = &log_gamma_LUT[1];
+    for (int k = first; k <= last; ++k) {
+        dest[k-k_start] -= scale * exp(-lambda + k*log_lambda - log_gamma[k]);
+    }
+}
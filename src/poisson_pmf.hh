@@ -3,6 +3,9 @@
 
 #include <cmath>
 #include <cassert>
+#include <cfloat>
+
+class ErrorTracker;
 
 // Computes the probability of a Poisson random variable with intensity lambda:
 // Pr[Pois(lambda)=k] = e^-lambda * lambda^k / k!
@@ -17,6 +20,16 @@ inline double poisson_pmf(double lambda, int k)
     return std::exp(-lambda + k*std::log(lambda) - std::lgamma(k+1));
 }
 
+// A bound on the relative error of poisson_pmf(lambda, j) for j <= k. The terms of the exponent are much larger than
+// the exponent itself near the mode, e.g. about 9e4 for lambda=k=10000, so their rounding is amplified by the cancellation.
+inline double poisson_pmf_relative_error(double lambda, int k)
+{
+    if (lambda == 0.0) {
+        return 0.0;
+    }
+    return DBL_EPSILON * (4.0 + 3.0*(lambda + k*std::fabs(std::log(lambda)) + std::lgamma(k+1)));
+}
+
 
 class PoissonPMFGenerator {
 public:
@@ -38,9 +51,15 @@ public:
     // Returns the smallest integer N such that for all indices i >= N we have that due to double-precision rounding
     //     Pr[Pois(lambda) = i] = 0
     void compute_array(int k, double lambda); 
+    // Subtracts scale * Pr[Pois(lambda) = k_start + j] from dest[j] for j=0,...,count-1.
+    // A single vectorized pass, much faster than calling evaluate_pmf() for each entry.
+    void subtract_scaled_pmf(double scale, double lambda, int k_start, int count, double* dest) const;
     const double* get_array() const {return pmf_array_ptr;}
+    // Reports the round-off errors of compute_array() and subtract_scaled_pmf() to tracker, if not NULL.
+    void set_error_tracker(ErrorTracker* tracker) { error_tracker = tracker; }
 private:
     int max_k;
+    ErrorTracker* error_tracker;
     double* log_gamma_LUT;
     double* pmf_array_ptr;
 };
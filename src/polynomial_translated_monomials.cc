@@ -0,0 +1,110 @@
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cassert>
+#include "mm_malloc.h"
+
+#include "polynomial_translated_monomials.hh"
+
+using namespace std;
+
+#if FLOAT_PRECISION_BITS == 128
+    string float128_to_string(__float128 x)
+    {
+        char s[1000];
+        quadmath_snprintf(s, sizeof(s), "%.30Qg", x);
+        return string(s);
+    }
+#endif
+
+static string long_double_to_string(long double x)
+{
+    stringstream ss;
+    ss.precision(22);
+    ss << x;
+    return ss.str();
+}
+
+PolynomialTranslatedMonomials::PolynomialTranslatedMonomials(int max_degree) :
+    degree(0)
+{
+    assert(max_degree >= 0);
+    multiplicative_coefficients = (FLOAT*)_mm_malloc(sizeof(FLOAT)*(max_degree+1), 32);
+    additive_coefficients = (FLOAT*)_mm_malloc(sizeof(FLOAT)*(max_degree+1), 32);
+    memset(multiplicative_coefficients, 0, sizeof(FLOAT)*(max_degree+1));
+    memset(additive_coefficients, 0, sizeof(FLOAT)*(max_degree+1));
+}
+
+PolynomialTranslatedMonomials::~PolynomialTranslatedMonomials()
+{
+    _mm_free(multiplicative_coefficients);
+    _mm_free(additive_coefficients);
+}
+
+FLOAT PolynomialTranslatedMonomials::get_multiplicative_coefficient(int degree) const
+{
+    assert(degree >= 0);
+    assert(degree <= this->degree);
+    return multiplicative_coefficients[degree];
+}
+
+void PolynomialTranslatedMonomials::set_multiplicative_coefficient(int degree, FLOAT multiplicative_coefficient)
+{
+    assert(degree >= 0);
+    assert(degree <= this->degree);
+
+    multiplicative_coefficients[degree] = multiplicative_coefficient;
+}
+
+void PolynomialTranslatedMonomials::set_additive_coefficient(int degree, FLOAT additive_coefficient)
+{
+    assert(degree >= 0);
+    assert(degree <= this->degree);
+
+    additive_coefficients[degree] = additive_coefficient;
+}
+
+FLOAT PolynomialTranslatedMonomials::evaluate(FLOAT x) const
+{
+    FLOAT result = 0.0;
+    for (int i = 0; i < degree+1; ++i) {
+        result += multiplicative_coefficients[i] * POW(x+additive_coefficients[i], i);
+    }
+    return result;
+}
+
+void PolynomialTranslatedMonomials::integrate()
+{
+    for (int i = degree+1; i >= 1; --i) {
+        multiplicative_coefficients[i] = multiplicative_coefficients[i-1] / FLOAT(i);
+        additive_coefficients[i] = additive_coefficients[i-1];
+    }
+    additive_coefficients[1] = 0.0;
+    additive_coefficients[0] = 0.0;
+    multiplicative_coefficients[0] = 0.0;
+    ++degree;
+}
+
+void PolynomialTranslatedMonomials::ldexp_all_multiplicative_coefficients(int exp)
+{
+    for (int i = 0; i < degree+1; ++i) {
+        multiplicative_coefficients[i] = LDEXP(multiplicative_coefficients[i], exp);
+    }
+}
+
+ostream& operator<<(ostream& stream, const PolynomialTranslatedMonomials& poly)
+{
+    for (int i = poly.degree; i >= 0; --i) {
+        FLOAT coef = poly.multiplicative_coefficients[i];
+        if (coef >= 0) {
+            stream << (i != poly.degree ? " + " : "") << TO_STRING(coef);
+            
+        } else {
+            stream << (i != poly.degree ? " - " : "") << TO_STRING(-coef);
+        }
+        if (i >= 1) {
+            stream << " (x + " << TO_STRING(poly.additive_coefficients[i]) << ")^" << i;
+        }
+    }
+    return stream;
+}
@@ -0,0 +1,70 @@
+#ifndef __polynomial_translated_monomials_hh__
+#define __polynomial_translated_monomials_hh__
+
+#include <ostream>
+
+// The floating point type of the polynomial computations of ecdf1_mns2016, which are prone to cancellation errors.
+#define FLOAT_PRECISION_BITS 80
+
+#if FLOAT_PRECISION_BITS == 128
+    extern "C" {
+        #include <quadmath.h> // Supported in GCC but not clang
+    }
+    typedef __float128 FLOAT;
+    #define EXP expq
+    #define LOG logq
+    #define GAMMA tgammaq
+    #define LOG_GAMMA lgammaq
+    #define POW powq
+    #define FREXP frexpq
+    #define LDEXP ldexpq
+    #define MAX_EXP FLT128_MAX_EXP
+    #define TO_STRING float128_to_string
+#elif FLOAT_PRECISION_BITS == 80
+    typedef long double FLOAT;
+    #include <cmath>
+    #include <cfloat>
+    #define EXP expl
+    #define LOG logl
+    #define GAMMA tgammal
+    #define LOG_GAMMA lgammal
+    #define POW powl
+    #define FREXP frexpl
+    #define LDEXP ldexpl
+    #define MAX_EXP LDBL_MAX_EXP
+    #define TO_STRING long_double_to_string
+#elif FLOAT_PRECISION_BITS == 64
+    typedef double FLOAT;
+    #include <cmath>
+    #include <cfloat>
+    #define EXP exp
+    #define LOG log
+    #define GAMMA tgamma
+    #define LOG_GAMMA lgamma
+    #define POW pow
+    #define FREXP frexp
+    #define LDEXP ldexp
+    #define MAX_EXP DBL_MAX_EXP
+    #define TO_STRING double_to_string
+#else
+    #error FLOAT_PRECISION_BITS must be 64, 80 or 128.
+#endif
+
+class PolynomialTranslatedMonomials {
+public:
+    PolynomialTranslatedMonomials(int max_degree);
+    ~PolynomialTranslatedMonomials();
+    FLOAT get_multiplicative_coefficient(int degree) const;
+    void set_multiplicative_coefficient(int degree, FLOAT multiplicative_coefficient);
+    void set_additive_coefficient(int degree, FLOAT additive_coefficient);
+    FLOAT evaluate(FLOAT x) const;
+    void integrate();
+    void ldexp_all_multiplicative_coefficients(int exp);
+    friend std::ostream& operator<<(std::ostream& stream, const PolynomialTranslatedMonomials& poly);
+    int degree;
+private:
+    FLOAT* __restrict__ multiplicative_coefficients;
+    FLOAT* __restrict__ additive_coefficients;
+};
+
+#endif
@@ -0,0 +1,183 @@
+#include <map>
+#include <string>
+#include <sstream>
+#include <set>
+#include <mutex>
+
+#include "profiling.hh"
+
+using namespace std;
+
+#ifdef CROSSPROB_STATS
+
+static const char* PHASE_NAMES[NUM_PROFILING_PHASES] = {"pmf", "fft_convolution", "naive_convolution", "rank_one_correction", "sorting"};
+
+// The counters of one thread. Only get_profiling_stats() and reset_profiling_stats() lock the mutex of another
+// thread's counters, so the threads don't contend for it.
+struct ProfilingCounters {
+    mutex counters_mutex;
+    double phase_seconds[NUM_PROFILING_PHASES];
+    long phase_calls[NUM_PROFILING_PHASES];
+    map<int, long> fft_padded_sizes;
+    map<int, long> fft_sizes;
+    map<int, long> naive_sizes;
+
+    ProfilingCounters() { clear(); }
+
+    void clear()
+    {
+        for (int phase = 0; phase < NUM_PROFILING_PHASES; ++phase) {
+            phase_seconds[phase] = 0.0;
+            phase_calls[phase] = 0;
+        }
+        fft_padded_sizes.clear();
+        fft_sizes.clear();
+        naive_sizes.clear();
+    }
+
+    // The caller holds the mutexes of both.
+    void add_to(ProfilingCounters& total) const
+    {
+        for (int phase = 0; phase < NUM_PROFILING_PHASES; ++phase) {
+            total.phase_seconds[phase] += phase_seconds[phase];
+            total.phase_calls[phase] += phase_calls[phase];
+        }
+        add_histogram_to(fft_padded_sizes, total.fft_padded_sizes);
+        add_histogram_to(fft_sizes, total.fft_sizes);
+        add_histogram_to(naive_sizes, total.naive_sizes);
+    }
+
+    static void add_histogram_to(const map<int, long>& histogram, map<int, long>& total)
+    {
+        for (map<int, long>::const_iterator it = histogram.begin(); it != histogram.end(); ++it) {
+            total[it->first] += it->second;
+        }
+    }
+};
+
+// The counters of the running threads, and the sum of those of the threads that have exited, under registry_mutex.
+static mutex registry_mutex;
+static set<ProfilingCounters*> thread_counters;
+static ProfilingCounters exited_threads_counters;
+
+// Registers the counters of a thread on its first profiled call and adds them to exited_threads_counters when it exits.
+class ThreadCountersRegistration {
+public:
+    ThreadCountersRegistration()
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        thread_counters.insert(&counters);
+    }
+    ~ThreadCountersRegistration()
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        thread_counters.erase(&counters);
+        lock_guard<mutex> exited_lock(exited_threads_counters.counters_mutex);
+        counters.add_to(exited_threads_counters);
+    }
+    ProfilingCounters counters;
+};
+
+static ProfilingCounters& this_thread_counters()
+{
+    thread_local ThreadCountersRegistration registration;
+    return registration.counters;
+}
+
+void add_phase_time(ProfilingPhase phase, double seconds)
+{
+    ProfilingCounters& counters = this_thread_counters();
+    lock_guard<mutex> lock(counters.counters_mutex);
+    counters.phase_seconds[phase] += seconds;
+    ++counters.phase_calls[phase];
+}
+
+// The smallest power of 2 that is >= size.
+static int size_bucket(int size)
+{
+    int bucket = 1;
+    while (bucket < size) {
+        bucket *= 2;
+    }
+    return bucket;
+}
+
+void record_convolution(bool fft, int size, int padded_size)
+{
+    ProfilingCounters& counters = this_thread_counters();
+    lock_guard<mutex> lock(counters.counters_mutex);
+    if (fft) {
+        ++counters.fft_padded_sizes[padded_size];
+        ++counters.fft_sizes[size_bucket(size)];
+    } else {
+        ++counters.naive_sizes[size_bucket(size)];
+    }
+}
+
+bool profiling_stats_enabled()
+{
+    return true;
+}
+
+void reset_profiling_stats()
+{
+    lock_guard<mutex> lock(registry_mutex);
+    for (set<ProfilingCounters*>::iterator it = thread_counters.begin(); it != thread_counters.end(); ++it) {
+        lock_guard<mutex> counters_lock((*it)->counters_mutex);
+        (*it)->clear();
+    }
+    lock_guard<mutex> exited_lock(exited_threads_counters.counters_mutex);
+    exited_threads_counters.clear();
+}
+
+static void add_histogram(const string& prefix, const map<int, long>& histogram, map<string, double>& stats)
+{
+    for (map<int, long>::const_iterator it = histogram.begin(); it != histogram.end(); ++it) {
+        stringstream ss;
+        ss << prefix << it->first;
+        stats[ss.str()] = it->second;
+    }
+}
+
+map<string, double> get_profiling_stats()
+{
+    ProfilingCounters total;
+    {
+        lock_guard<mutex> lock(registry_mutex);
+        lock_guard<mutex> total_lock(total.counters_mutex);
+        for (set<ProfilingCounters*>::iterator it = thread_counters.begin(); it != thread_counters.end(); ++it) {
+            lock_guard<mutex> counters_lock((*it)->counters_mutex);
+            (*it)->add_to(total);
+        }
+        lock_guard<mutex> exited_lock(exited_threads_counters.counters_mutex);
+        exited_threads_counters.add_to(total);
+    }
+
+    map<string, double> stats;
+    for (int phase = 0; phase < NUM_PROFILING_PHASES; ++phase) {
+        stats[string(PHASE_NAMES[phase]) + "_seconds"] = total.phase_seconds[phase];
+        stats[string(PHASE_NAMES[phase]) + "_calls"] = total.phase_calls[phase];
+    }
+    add_histogram("fft_padded_size_", total.fft_padded_sizes, stats);
+    add_histogram("fft_size_", total.fft_sizes, stats);
+    add_histogram("naive_size_", total.naive_sizes, stats);
+    return stats;
+}
+
+#else
+
+bool profiling_stats_enabled()
+{
+    return false;
+}
+
+void reset_profiling_stats()
+{
+}
+
+map<string, double> get_profiling_stats()
+{
+    return map<string, double>();
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef __profiling_hh__
+#define __profiling_hh__
+
+#include <map>
+#include <string>
+
+// Opt-in profiling counters. When compiled with -DCROSSPROB_STATS (e.g. "make clean; make STATS=1"), the wall time
+// and number of calls of each phase below are accumulated, along with histograms of the sizes of the convolutions.
+// Otherwise the PROFILE_* macros expand to nothing and get_profiling_stats() returns an empty map.
+// Each thread accumulates its own counters, and get_profiling_stats() returns their sums over all the threads,
+// including those that have exited since the last reset. The seconds are summed too, so they can exceed the wall time.
+
+enum ProfilingPhase {
+    PHASE_PMF,                  // PoissonPMFGenerator::compute_array()
+    PHASE_FFT_CONVOLUTION,      // FFTWConvolver::convolve_same_size() using FFTs
+    PHASE_NAIVE_CONVOLUTION,    // Direct O(size^2) convolutions
+    PHASE_RANK_ONE_CORRECTION,  // PoissonPMFGenerator::subtract_scaled_pmf()
+    PHASE_SORTING,              // join_all_bounds()
+    NUM_PROFILING_PHASES
+};
+
+// True if the library was compiled with -DCROSSPROB_STATS.
+bool profiling_stats_enabled();
+
+void reset_profiling_stats();
+
+// Returns the counters accumulated since the last reset:
+//     "<phase>_seconds" and "<phase>_calls" for each phase, e.g. "fft_convolution_seconds".
+//     "fft_padded_size_<N>": the number of FFT convolutions that used FFTs of size N.
+//     "fft_size_<S>" and "naive_size_<S>": the number of convolutions of input size in (S/2, S], for S a power of 2.
+std::map<std::string, double> get_profiling_stats();
+
+#ifdef CROSSPROB_STATS
+
+#include <chrono>
+
+void add_phase_time(ProfilingPhase phase, double seconds);
+void record_convolution(bool fft, int size, int padded_size);
+
+// Adds the lifetime of the object to the phase.
+class ScopedPhaseTimer {
+public:
+    ScopedPhaseTimer(ProfilingPhase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedPhaseTimer() { add_phase_time(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()); }
+private:
+    ProfilingPhase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define PROFILE_PHASE(phase) ScopedPhaseTimer scoped_phase_timer(phase)
+#define PROFILE_CONVOLUTION(fft, size, padded_size) record_convolution(fft, size, padded_size)
+
+#else
+
+#define PROFILE_PHASE(phase)
+#define PROFILE_CONVOLUTION(fft, size, padded_size)
+
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#include <algorithm>
+
+#include "sorted_bounds.hh"
+#include "profiling.hh"
+
+using namespace std;
+
+// b, B and query_locations are each sorted, so they are merged in linear time rather than sorted.
+// At equal locations b steps come before B steps, and queries are placed after all the bounds so that
+// they see the effect of these bounds.
+// The output buffers are overwritten, keeping their capacity.
+void join_all_bounds(const vector<double>& b, const vector<double>& B, const vector<double>& query_locations, SortedBounds& bounds)
+{
+    join_all_bounds(b.data(), b.size(), B.data(), B.size(), query_locations, bounds);
+}
+
+void join_all_bounds(const double* b, int b_size, const double* B, int B_size, const vector<double>& query_locations, SortedBounds& bounds)
+{
+    PROFILE_PHASE(PHASE_SORTING);
+    unsigned int total_size = b_size + B_size + query_locations.size() + 1;
+    bounds.locations.resize(total_size);
+    bounds.tags.resize(total_size);
+    double* locations = bounds.locations.data();
+    BoundType* tags = bounds.tags.data();
+
+    unsigned int i = 0;
+    unsigned int j = 0;
+    unsigned int k = 0;
+    for (unsigned int pos = 0; pos < total_size-1; ++pos) {
+        bool take_b = (i < (unsigned int)b_size) && ((j == (unsigned int)B_size) || (b[i] <= B[j]));
+        double bound_location = take_b ? b[i] : ((j < (unsigned int)B_size) ? B[j] : 1.0);
+        if ((k < query_locations.size()) && ((i+j == (unsigned int)(b_size+B_size)) || (query_locations[k] < bound_location))) {
+            locations[pos] = query_locations[k++];
+            tags[pos] = QUERY;
+        } else if (take_b) {
+            locations[pos] = b[i++];
+            tags[pos] = bSTEP;
+        } else {
+            locations[pos] = B[j++];
+            tags[pos] = BSTEP;
+        }
+    }
+
+    locations[total_size-1] = 1.0;
+    tags[total_size-1] = END;
+}
+
+int maximum_window_size(const vector<double>& b, const vector<double>& B)
+{
+    unsigned int i = 0;
+    unsigned int j = 0;
+    int max_size = 1;
+    while (i < b.size()) {
+        if ((j == B.size()) || (b[i] <= B[j])) {
+            ++i;
+            max_size = max(max_size, int(i) - int(j) + 1);
+        } else {
+            ++j;
+        }
+    }
+    return max_size;
+}
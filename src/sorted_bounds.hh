@@ -0,0 +1,27 @@
+#ifndef __sorted_bounds_hh__
+#define __sorted_bounds_hh__
+
+#include <vector>
+
+enum BoundType {bSTEP, BSTEP, END, QUERY};
+
+// The steps of the boundaries b and B (and optional query locations) sorted by location.
+// Locations and tags are kept in separate arrays so that the sweeps read them sequentially,
+// and so that the buffers can be reused between calls (see ComputationContext).
+struct SortedBounds {
+    std::vector<double> locations;
+    std::vector<BoundType> tags;
+
+    unsigned int size() const { return locations.size(); }
+};
+
+// Merges the sorted b, B and query_locations into bounds, followed by an END step at 1.
+void join_all_bounds(const std::vector<double>& b, const std::vector<double>& B, const std::vector<double>& query_locations, SortedBounds& bounds);
+void join_all_bounds(const double* b, int b_size, const double* B, int B_size, const std::vector<double>& query_locations, SortedBounds& bounds);
+
+// The size of the largest active window [B_step_count, b_step_count] during a sweep over the bounds joined by
+// join_all_bounds(b, B, ...), i.e. the maximum of the number of b_i < t minus the number of B_i < t, plus 1.
+// Computed by the same merge, without allocating the sorted bounds.
+int maximum_window_size(const std::vector<double>& b, const std::vector<double>& B);
+
+#endif
@@ -0,0 +1,218 @@
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+#include "threshold_search.hh"
+#include "boundary_families.hh"
+#include "computation_context.hh"
+#include "ecdf1_new.hh"
+#include "ecdf2.hh"
+
+using namespace std;
+
+const int MAX_BRACKETING_STEPS = 100;
+const int MAX_BRENT_ITERATIONS = 100;
+const double RELATIVE_THRESHOLD_TOLERANCE = 1e-13;
+
+// Evaluates f(x) = crossing_probability(x) - alpha for a fixed family and sample size.
+class CrossingProbabilityMinusAlpha {
+public:
+    CrossingProbabilityMinusAlpha(const BoundaryFamily& family, int n, double alpha) :
+        family(family), n(n), alpha(alpha), ctx(n)
+    {
+    }
+
+    double operator()(double x)
+    {
+        family.compute_bounds(n, x, b, B);
+        double noncrossing_probability;
+        if (B.empty()) {
+            noncrossing_probability = ecdf1_new_b(b, ctx);
+        } else if (b.empty()) {
+            noncrossing_probability = ecdf1_new_B(B, ctx);
+        } else {
+            noncrossing_probability = ecdf2(b, B, true, ctx);
+        }
+        return (1.0 - noncrossing_probability) - alpha;
+    }
+
+private:
+    const BoundaryFamily& family;
+    int n;
+    double alpha;
+    ComputationContext ctx;
+    vector<double> b;
+    vector<double> B;
+};
+
+static inline bool have_opposite_signs(double fa, double fb)
+{
+    return ((fa <= 0.0) && (fb >= 0.0)) || ((fa >= 0.0) && (fb <= 0.0));
+}
+
+// Brent's method for finding a root of f in [a,b], where f(a) and f(b) have opposite signs.
+// See R.P. Brent (1973), Algorithms for Minimization without Derivatives, Chapter 4.
+static double brent_root(CrossingProbabilityMinusAlpha& f, double a, double b, double fa, double fb)
+{
+    const double EPSILON = numeric_limits<double>::epsilon();
+
+    double c = b;
+    double fc = fb;
+    double d = b - a;
+    double e = d;
+    for (int iteration = 0; iteration < MAX_BRENT_ITERATIONS; ++iteration) {
+        if (have_opposite_signs(fb, fc) == false) {
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (fabs(fc) < fabs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        double tolerance = 2.0*EPSILON*fabs(b) + 0.5*RELATIVE_THRESHOLD_TOLERANCE*fabs(b);
+        double m = 0.5*(c - b);
+        if ((fabs(m) <= tolerance) || (fb == 0.0)) {
+            return b;
+        }
+        if ((fabs(e) >= tolerance) && (fabs(fa) > fabs(fb))) {
+            // Attempt inverse quadratic interpolation (or the secant method if only two points are distinct)
+            double p, q, r;
+            double s = fb / fa;
+            if (a == c) {
+                p = 2.0*m*s;
+                q = 1.0 - s;
+            } else {
+                q = fa / fc;
+                r = fb / fc;
+                p = s*(2.0*m*q*(q - r) - (b - a)*(r - 1.0));
+                q = (q - 1.0)*(r - 1.0)*(s - 1.0);
+            }
+            if (p > 0.0) {
+                q = -q;
+            } else {
+                p = -p;
+            }
+            if ((2.0*p < 3.0*m*q - fabs(tolerance*q)) && (p < fabs(0.5*e*q))) {
+                e = d;
+                d = p / q;
+            } else {
+                d = m;
+                e = m;
+            }
+        } else {
+            // Bisection
+            d = m;
+            e = m;
+        }
+        a = b;
+        fa = fb;
+        if (fabs(d) > tolerance) {
+            b += d;
+        } else {
+            b += (m > 0.0) ? tolerance : -tolerance;
+        }
+        fb = f(b);
+    }
+    throw runtime_error("find_threshold(): Brent's method did not converge.");
+}
+
+double find_threshold(const BoundaryFamily& family, int n, double alpha)
+{
+    if (n <= 0) {
+        throw runtime_error("find_threshold() expects n > 0.");
+    }
+    if ((alpha <= 0.0) || (alpha >= 1.0)) {
+        throw runtime_error("find_threshold() expects 0 < alpha < 1.");
+    }
+
+    pair<double, double> bracket = family.bracket(n, alpha);
+    double low = bracket.first;
+    double high = bracket.second;
+
+    CrossingProbabilityMinusAlpha f(family, n, alpha);
+
+    double x0 = family.asymptotic_threshold(n, alpha);
+    if (!((x0 > low) && (x0 < high))) {
+        x0 = 0.5*(low + high);
+    }
+    double f0 = f(x0);
+    if (f0 == 0.0) {
+        return x0;
+    }
+
+    // Step from the initial guess towards the root until it is bracketed.
+    // Each step extrapolates the secant through the last two points and overshoots it slightly.
+    bool root_is_above = (f0 < 0.0) == family.is_crossing_probability_increasing();
+    double limit = root_is_above ? high : low;
+    double x1 = x0;
+    double f1 = f0;
+    double step = 0.05*x0;
+    for (int i = 0; i < MAX_BRACKETING_STEPS; ++i) {
+        double x2 = root_is_above ? min(x1 + step, limit) : max(x1 - step, limit);
+        double f2 = f(x2);
+        if (have_opposite_signs(f1, f2)) {
+            return brent_root(f, x1, x2, f1, f2);
+        }
+        if (x2 == limit) {
+            stringstream ss;
+            ss << "find_threshold(): no threshold with crossing probability " << alpha << " in the interval [" << low << ", " << high << "].";
+            throw runtime_error(ss.str());
+        }
+        double secant_step = (f2 != f1) ? fabs(f2 * (x2 - x1) / (f2 - f1)) : 0.0;
+        step = max(2.0*fabs(x2 - x1), 1.2*secant_step);
+        x1 = x2;
+        f1 = f2;
+    }
+    throw runtime_error("find_threshold(): unable to bracket the threshold.");
+}
+
+double find_threshold(const string& family_name, int n, double alpha)
+{
+    return find_threshold(get_boundary_family(family_name), n, alpha);
+}
+
+double boundary_family_crossing_probability(const string& family_name, int n, double x)
+{
+    CrossingProbabilityMinusAlpha f(get_boundary_family(family_name), n, 0.0);
+    return f(x);
+}
+
+vector<double> boundary_family_crossing_probabilities(const string& family_name, int n, const vector<double>& x)
+{
+    if (n <= 0) {
+        throw runtime_error("boundary_family_crossing_probabilities() expects n > 0.");
+    }
+    const BoundaryFamily& family = get_boundary_family(family_name);
+    vector<vector<double> > b(x.size());
+    vector<vector<double> > B(x.size());
+    for (unsigned int j = 0; j < x.size(); ++j) {
+        family.compute_bounds(n, x[j], b[j], B[j]);
+    }
+
+    vector<double> noncrossing_probabilities(x.size());
+    ComputationContext ctx(n);
+    for (unsigned int j = 0; j < x.size(); ++j) {
+        if (B[j].empty()) {
+            noncrossing_probabilities[j] = ecdf1_new_b(b[j], ctx);
+        } else if (b[j].empty()) {
+            noncrossing_probabilities[j] = ecdf1_new_B(B[j], ctx);
+        } else {
+            noncrossing_probabilities[j] = ecdf2(b[j], B[j], true, ctx);
+        }
+    }
+
+    vector<double> probabilities(x.size());
+    for (unsigned int j = 0; j < x.size(); ++j) {
+        probabilities[j] = 1.0 - noncrossing_probabilities[j];
+    }
+    return probabilities;
+}
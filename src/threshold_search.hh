@@ -0,0 +1,28 @@
+#ifndef __threshold_search_hh__
+#define __threshold_search_hh__
+
+#include <string>
+#include <vector>
+
+class BoundaryFamily;
+
+// Finds the threshold x such that the boundaries of the given family at x have crossing probability alpha,
+// i.e. the critical value of a level-alpha test for a sample of size n.
+//
+// The search starts from the family's asymptotic approximation of the threshold, brackets the root using
+// secant steps and then refines it using Brent's method. All evaluations share a single ComputationContext.
+// One-sided families are evaluated using the O(n^2) ecdf1-new algorithm and two-sided families using ecdf2-mn2017.
+double find_threshold(const BoundaryFamily& family, int n, double alpha);
+
+// Same as above for one of the families returned by get_boundary_family(), e.g. "ks" or "mn-plus".
+double find_threshold(const std::string& family_name, int n, double alpha);
+
+// The crossing probability of the boundaries of the named family at threshold x.
+double boundary_family_crossing_probability(const std::string& family_name, int n, double x);
+
+// The crossing probabilities of the named family at each of the thresholds x, e.g. a curve of the null CDF of the statistic.
+// Each threshold is computed separately, sharing a single ComputationContext: two-sided families by ecdf2() and
+// one-sided families by ecdf1-new, which is O(n^2) rather than O(n^2 log n) per threshold.
+std::vector<double> boundary_family_crossing_probabilities(const std::string& family_name, int n, const std::vector<double>& x);
+
+#endif
@@ -3,6 +3,12 @@
 # This test script can be run directly from the shell, but using the "py.test" package gives nicer-looking output.
 
 import subprocess
+import json
+import sys
+import tempfile
+import decimal
+import glob
+import threading
 
 EPSILON = 0.01
 
@@ -19,10 +25,16 @@ def test_ecdf2ks2001():
     assert run('./bin/crossprob ecdf2-ks2001 tests/bounds_cksplus_10.txt').strip() ==  b'0.608924'
     assert run('./bin/crossprob ecdf2-ks2001 tests/bounds_cksminus_10.txt').strip() ==  b'0.608924'
     
-#def test_poisson():
-#    assert run('./bin/crossprob poisson 2 tests/bounds2.txt').strip() == b'0.661662'
-#    assert run('./bin/crossprob poisson 10 tests/bounds8.txt').strip() == b'0.905357'
-#    assert run('./bin/crossprob poisson 7 tests/bounds_cksplus_10.txt').strip() ==  b'0.231013'
+def test_poisson():
+    assert run('./bin/crossprob poisson 2 tests/bounds2.txt').strip() == b'0.203003'
+    assert run('./bin/crossprob poisson 10 tests/bounds8.txt').strip() == b'0.0946427'
+    assert run('./bin/crossprob poisson 7 tests/bounds_cksplus_10.txt').strip() ==  b'0.768987'
+    assert run('./bin/crossprob poisson 2,8,10 tests/bounds8.txt').split() == [b'0.000722243', b'0.117326', b'0.0946427']
+    # More upper bounds B_i (second line) than lower bounds b_i (first line).
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write('0.1\n0.5, 0.9\n')
+        f.flush()
+        assert b'Expecting at most as many upper bounds B_i as lower bounds b_i.' in run('./bin/crossprob poisson 2 ' + f.name + ' 2>&1; true')
 
 def test_ecdf1mns2016():
     assert run('./bin/crossprob ecdf1-mns2016 tests/bounds_0.txt').strip() ==  b'1'
@@ -37,11 +49,184 @@ def test_ecdf2mn2017():
     assert run('./bin/crossprob ecdf2-mn2017 tests/bounds_cksminus_10.txt').strip() ==  b'0.608924'
     assert run('./bin/crossprob ecdf2-mn2017 tests/bounds_cksplus_10.txt').strip() ==  b'0.608924'
 
+def test_ecdf2blocked():
+    assert run('./bin/crossprob ecdf2-blocked tests/bounds_0_1.txt').strip() == b'1'
+    assert run('./bin/crossprob ecdf2-blocked tests/bounds2.txt').strip() == b'0.75'
+    assert run('./bin/crossprob ecdf2-blocked tests/bounds8.txt').strip() == b'0.840529'
+    assert run('./bin/crossprob ecdf2-blocked tests/bounds_cksminus_10.txt').strip() ==  b'0.608924'
+    assert run('./bin/crossprob ecdf2-blocked tests/bounds_cksplus_10.txt').strip() ==  b'0.608924'
+
+def test_ecdf2blocked_large_n():
+    # Two-sided and one-sided KS at n=2000, where the windows are large enough for the FFT convolutions of the blocks,
+    # the exit corrections of the low band and the truncation of the top band. ecdf2-blocked agrees with ecdf2-mn2017
+    # (and with ecdf2-ks2001 for two-sided bounds) with the calibrated jump size and with fixed ones. --with-error
+    # prints the probabilities with 17 digits.
+    def probability(args, filename):
+        return float(run('./bin/crossprob --with-error ' + args + ' ' + filename).split()[0])
+    n = 2000
+    for (d, two_sided) in [(0.03, True), (0.05, True), (0.02, False)]:
+        with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+            f.write((', '.join(repr(max(0.0, (i+1)/n - d)) for i in range(n)) if two_sided else '') + '\n')
+            f.write(', '.join(repr(min(1.0, i/n + d)) for i in range(n)) + '\n')
+            f.flush()
+            expected = [probability('ecdf2-mn2017', f.name)] + ([probability('ecdf2-ks2001', f.name)] if two_sided else [])
+            for jump_size in ['', '--jump-size=1 ', '--jump-size=20 ']:
+                p = probability(jump_size + 'ecdf2-blocked', f.name)
+                assert all(abs(p - e) < 1e-10 for e in expected)
+
 def test_ecdf1m2020():
     assert run('./bin/crossprob ecdf1-new tests/bounds_0.txt').strip() ==  b'1'
     assert run('./bin/crossprob ecdf1-new tests/bounds__1.txt').strip() ==  b'1'
     assert run('./bin/crossprob ecdf1-new tests/bounds_cksminus_10.txt').strip() ==  b'0.608924'
     assert run('./bin/crossprob ecdf1-new tests/bounds_cksplus_10.txt').strip() ==  b'0.608924'
+    assert run('./bin/crossprob --jump-size=3 ecdf1-new tests/bounds_cksplus_10.txt').strip() ==  b'0.608924'
+    assert run('./bin/crossprob --jump-size=1 ecdf1-new tests/bounds_cksminus_10.txt').strip() ==  b'0.608924'
+
+def test_ecdf1new_two_sided():
+    for filename in ['bounds_0_1.txt', 'bounds2.txt', 'bounds8.txt', 'bounds_cks_10.txt']:
+        expected = run('./bin/crossprob ecdf2-ks2001 tests/' + filename).strip()
+        assert run('./bin/crossprob ecdf1-new tests/' + filename).strip() == expected
+        assert run('./bin/crossprob --jump-size=2 ecdf1-new tests/' + filename).strip() == expected
+
+def test_auto():
+    assert run('./bin/crossprob auto tests/bounds_0_1.txt').strip() == b'1'
+    assert run('./bin/crossprob auto tests/bounds8.txt').strip() == b'0.840529'
+    assert run('./bin/crossprob auto tests/bounds_cks_10.txt').strip() == b'0.289872'
+    assert run('./bin/crossprob auto tests/bounds_cksminus_10.txt').strip() == b'0.608924'
+    assert run('./bin/crossprob auto tests/bounds_cksplus_10.txt').strip() == b'0.608924'
+    assert b'Chosen algorithm: ecdf2-ks2001' in run('./bin/crossprob --verbose auto tests/bounds8.txt 2>&1')
+    # One-sided KS at n=100: ecdf2-ks2001 overrides a faster estimate since its running time is negligible, and says so.
+    n = 100
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write('\n' + ', '.join(repr(min(1.0, i/n + 0.1)) for i in range(n)) + '\n')
+        f.flush()
+        assert b'Chosen algorithm: ecdf2-ks2001: its estimated running time is negligible' in run('./bin/crossprob --verbose auto ' + f.name + ' 2>&1')
+    # Two-sided KS at n=2000, whose error bound is about 3e-10: a larger tolerance keeps the chosen algorithm,
+    # a smaller one recomputes by ecdf2-dd.
+    n, d = 2000, 0.05
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write(', '.join(repr(max(0.0, (i+1)/n - d)) for i in range(n)) + '\n')
+        f.write(', '.join(repr(min(1.0, i/n + d)) for i in range(n)) + '\n')
+        f.flush()
+        output = run('./bin/crossprob --verbose --tolerance=1e-8 auto ' + f.name + ' 2>&1')
+        assert b'is within the tolerance' in output and b'Computed by: ecdf2-dd' not in output
+        output = run('./bin/crossprob --verbose --tolerance=1e-13 auto ' + f.name + ' 2>&1')
+        assert b'exceeds the tolerance' in output and b'Computed by: ecdf2-dd' in output
+        assert output.split()[-1] == run('./bin/crossprob ecdf2-mn2017 ' + f.name).strip()
+    assert b'--tolerance only applies to the auto algorithm' in run('./bin/crossprob --tolerance=1e-8 ecdf2-mn2017 tests/bounds8.txt; true')
+
+def test_stats():
+    output = run('./bin/crossprob --stats ecdf2-mn2017 tests/bounds8.txt 2>&1').split(b'\n')
+    assert output[0] == b'0.840529'
+    # The counters are only compiled in with "make STATS=1".
+    assert (b'not compiled in' in output[1]) or (b'naive_convolution_calls 10' in output)
+
+def test_low_memory():
+    for filename in ['tests/bounds8.txt', 'tests/bounds_cks_10.txt', 'tests/bounds_cksplus_10.txt']:
+        for algorithm in ['ecdf2-ks2001', 'ecdf2-mn2017']:
+            assert run(f'./bin/crossprob --low-memory {algorithm} {filename}') == run(f'./bin/crossprob {algorithm} {filename}')
+    peak_bytes = {}
+    for option in ['', '--low-memory']:
+        output = run(f'./bin/crossprob {option} --memory ecdf2-mn2017 tests/bounds_cks_10.txt 2>&1').split()
+        assert output[0] == b'0.289872'
+        assert output[1] == b'peak_allocated_bytes'
+        peak_bytes[option] = int(output[2])
+    assert 0 < peak_bytes['--low-memory'] < peak_bytes['']
+
+def test_ecdf2_warped():
+    assert run('./bin/crossprob ecdf2-warped tests/warps_3.txt tests/bounds8.txt').split() == [b'0.840529', b'0.724004', b'0.486082']
+    assert run('./bin/crossprob ecdf2-warped tests/warps_3.txt tests/bounds_cksplus_10.txt').split()[0] == b'0.608924'
+
+def test_threshold():
+    assert run('./bin/crossprob threshold ks-plus 10 0.05').startswith(b'0.368663')
+    assert run('./bin/crossprob threshold ks-minus 10 0.05').startswith(b'0.368663')
+    assert run('./bin/crossprob threshold ks 10 0.05').startswith(b'0.409246')
+    assert run('./bin/crossprob threshold mn-plus 1 0.05').startswith(b'0.05')
+    assert run('./bin/crossprob threshold mn-plus 10 0.05').startswith(b'0.00794337')
+
+def test_crossing():
+    # All the thresholds of a family in one sweep give the same results as one threshold at a time.
+    thresholds = ['0.409246', '0.3', '0.5']
+    output = run('./bin/crossprob crossing ks 10 ' + ','.join(thresholds))
+    assert output == b''.join(run('./bin/crossprob crossing ks 10 ' + x) for x in thresholds)
+    assert output.startswith(b'0.05')
+    assert run('./bin/crossprob crossing mn-plus 10 0.00794337,0.01').startswith(b'0.05')
+
+def test_reference():
+    assert run('./bin/crossprob ecdf2-reference tests/bounds8.txt').startswith(b'0.8405287799999999')
+    assert run('./bin/crossprob ecdf2-reference tests/bounds_cksplus_10.txt').startswith(b'0.608924211464497')
+    # The corpus cases with the reference engine. The FFT round-off errors at n=100 are around 1e-14.
+    lines = run('./bin/crossprob_bench --corpus --reference --max-n=100 --min-time=0.001 --filter=ks').split()
+    assert lines[0].endswith(b',result,reference')
+    for line in lines[1:]:
+        fields = line.split(b',')
+        assert abs(float(fields[6]) - float(fields[7])) < 1e-12
+
+def test_double_double():
+    # Both probabilities are the quad precision reference rounded to a double.
+    assert run('./bin/crossprob ecdf2-dd tests/bounds8.txt').split() == [b'0.84052877999999998', b'0.15947122']
+    assert run('./bin/crossprob ecdf2-dd tests/bounds_cks_10.txt').split() == [b'0.28987177260108066', b'0.71012822739891934']
+    # A two-sided Kolmogorov-Smirnov band with crossing probability 5.2e-17, where 1 - ecdf2-mn2017 is all round-off.
+    n, d = 300, 0.25
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write(', '.join(repr(max(0.0, (i+1)/n - d)) for i in range(n)) + '\n')
+        f.write(', '.join(repr(min(1.0, i/n + d)) for i in range(n)) + '\n')
+        f.flush()
+        crossing = float(run('./bin/crossprob ecdf2-dd ' + f.name).split()[1])
+        reference = 1 - decimal.Decimal(run('./bin/crossprob ecdf2-reference ' + f.name).strip().decode())
+        assert abs(crossing - float(reference)) < 1e-12 * crossing
+    # At n=4000 the first step has lambda=2000 over a window of 4001 counts, so it goes through the FFT convolution.
+    n = 4000
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write(', '.join(['0'] * n) + '\n')
+        f.write(', '.join(repr(min(1.0, max(0.5, (i+1)/n + 0.01))) for i in range(n)) + '\n')
+        f.flush()
+        (noncrossing, crossing) = run('./bin/crossprob ecdf2-dd ' + f.name).split()
+        reference = decimal.Decimal(run('./bin/crossprob ecdf2-reference ' + f.name).strip().decode())
+        assert float(noncrossing) == float(reference)
+        assert float(crossing) == float(1 - reference)
+    # A non-crossing probability within round-off of 1 gives a crossing probability of 0, not a negative one.
+    n = 3000
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write(', '.join(['0'] * n) + '\n')
+        f.write(', '.join(['0.5'] * 100 + ['1'] * (n-100)) + '\n')
+        f.flush()
+        assert run('./bin/crossprob ecdf2-dd ' + f.name).split() == [b'1', b'0']
+
+def test_with_error():
+    # The probability is the same as without --with-error, and its error bounds are small for n=10.
+    for algorithm in ['ecdf2-ks2001', 'ecdf2-mn2017', 'ecdf2-blocked', 'ecdf1-new', 'auto']:
+        lines = run('./bin/crossprob --with-error ' + algorithm + ' tests/bounds_cksplus_10.txt').split(b'\n')
+        assert ('%g' % float(lines[0])).encode() == run('./bin/crossprob ' + algorithm + ' tests/bounds_cksplus_10.txt').strip()
+        fields = dict(line.split() for line in lines[1:] if line)
+        assert 0 < float(fields[b'error_estimate']) <= float(fields[b'error_bound']) < 1e-12
+        assert fields[b'negative_entries'] == b'0'
+    assert b'--with-error expects' in run('./bin/crossprob --with-error ecdf1-mns2016 tests/bounds8.txt; true')
+    assert b"doesn't support --low-memory" in run('./bin/crossprob --with-error --low-memory ecdf2-mn2017 tests/bounds8.txt; true')
+
+    # Two-sided KS at n=2000, where the errors are above 1e-12: the printed probability is within error_bound and
+    # error_estimate of the quad precision reference. A fixed jump size changes the convolutions of ecdf2-blocked.
+    n, d = 2000, 0.03
+    with tempfile.NamedTemporaryFile('w', suffix='.txt') as f:
+        f.write(', '.join(repr(max(0.0, (i+1)/n - d)) for i in range(n)) + '\n')
+        f.write(', '.join(repr(min(1.0, i/n + d)) for i in range(n)) + '\n')
+        f.flush()
+        reference = decimal.Decimal(run('./bin/crossprob ecdf2-reference ' + f.name).strip().decode())
+        naive_convolutions = set()
+        for args in ['ecdf2-mn2017', 'ecdf2-blocked', 'ecdf1-new', '--jump-size=1 ecdf2-blocked']:
+            lines = run('./bin/crossprob --with-error ' + args + ' ' + f.name).split(b'\n')
+            fields = dict(line.split() for line in lines[1:] if line)
+            error = abs(decimal.Decimal(lines[0].decode()) - reference)
+            assert error <= decimal.Decimal(fields[b'error_estimate'].decode()) <= decimal.Decimal(fields[b'error_bound'].decode())
+            if 'blocked' in args:
+                naive_convolutions.add(fields[b'naive_convolutions'])
+        assert len(naive_convolutions) == 2
+
+def test_fft_backends():
+    # Large enough for FFT convolutions, in ecdf2-mn2017 and ecdf1-new. The builtin FFT agrees with the default backend.
+    for args in ['crossing ks 3000 0.02,0.03', 'crossing ks-plus 3000 0.02']:
+        assert run('./bin/crossprob --fft=builtin ' + args) == run('./bin/crossprob ' + args)
+    assert b'Unknown FFT backend' in run('./bin/crossprob --fft=none ecdf2-mn2017 tests/bounds8.txt; true')
 
 def test_crossprob_mc_binomial():
     binomial_bounds_0 = float(run('./bin/crossprob_mc ecdf tests/bounds_0.txt 1000'))
@@ -61,16 +246,168 @@ def test_crossprob_mc_binomial():
     binomial_cksminus_10 = float(run('./bin/crossprob_mc ecdf tests/bounds_cksminus_10.txt 1000000'))
     assert abs(binomial_cksminus_10 - 0.608924) < EPSILON
 
-#def test_crossprob_mc_poisson():
-#    poisson_bounds2 = float(run('./bin/crossprob_mc poisson 2 tests/bounds2.txt 1000000'))
-#    assert abs(poisson_bounds2 - 0.661662) < EPSILON
-#
-#    poisson_bounds8 = float(run('./bin/crossprob_mc poisson 10 tests/bounds8.txt 1000000'))
-#    assert abs(poisson_bounds8 - 0.905357) < EPSILON
-#
-#    poisson_cksplus_10 = float(run('./bin/crossprob poisson 7 tests/bounds_cksplus_10.txt'))
-#    assert abs(poisson_cksplus_10 - 0.231013) < EPSILON
+def test_crossprob_mc_poisson():
+    poisson_bounds2 = float(run('./bin/crossprob_mc poisson 2 tests/bounds2.txt 1000000'))
+    assert abs(poisson_bounds2 - 0.203003) < EPSILON
+
+    poisson_bounds8 = float(run('./bin/crossprob_mc poisson 10 tests/bounds8.txt 1000000'))
+    assert abs(poisson_bounds8 - 0.0946427) < EPSILON
+
+    poisson_cksplus_10 = float(run('./bin/crossprob_mc poisson 7 tests/bounds_cksplus_10.txt 1000000'))
+    assert abs(poisson_cksplus_10 - 0.768987) < EPSILON
+
+def test_crossprob_bench():
+    lines = run('./bin/crossprob_bench --filter=ecdf1-new --max-n=100 --min-time=0.001').split()
+    assert lines[0] == b'benchmark,size,samples,median_ns,p99_ns,items_per_second'
+    assert [line.split(b',')[:2] for line in lines[1:]] == [[b'ecdf1-new', b'10'], [b'ecdf1-new', b'30'], [b'ecdf1-new', b'100']]
+
+    records = json.loads(run('./bin/crossprob_bench --format=json --filter=fftwconvolver --max-n=10 --min-time=0.001'))
+    assert [r['size'] for r in records] == [16, 32, 64, 127, 128]
+    assert all(0 < r['median_ns'] <= r['p99_ns'] for r in records)
+
+def test_batch():
+    # Computing several files in parallel gives the same results as one by one, in the order of the files.
+    files = 'tests/bounds2.txt tests/bounds8.txt tests/bounds_cksplus_10.txt tests/bounds_cks_10.txt'
+    expected = b''.join(run('./bin/crossprob auto ' + f) for f in files.split())
+    assert run('./bin/crossprob --threads=3 batch auto ' + files) == expected
+
+def test_checkpoints():
+    # Resuming from the checkpoints of a shared prefix gives the same result as an uninterrupted run, with FFT convolutions.
+    output = run('./bin/crossprob_bench --check --filter=checkpoints')
+    assert output.strip().endswith(b'check: 2 checks, 0 failures')
+
+def test_all_sample_sizes_and_prefixes():
+    # ecdf2_all_sample_sizes() and ecdf2_prefix_noncrossing_probabilities() agree with separate ecdf2() calls at n=3000.
+    for name in ['ecdf2_all_sample_sizes', 'ecdf2_prefix_noncrossing_probabilities']:
+        output = run('./bin/crossprob_bench --check --filter=' + name)
+        assert output.strip().endswith(b'check: 1 checks, 0 failures')
+
+def test_convolve_many():
+    # The batched convolutions agree with separate ones for each FFT backend, with mixed sizes, shared kernels and in place.
+    output = run('./bin/crossprob_bench --check --filter=convolve_many')
+    assert b'convolve_many/builtin' in output
+    assert output.strip().endswith(b' checks, 0 failures')
+
+def test_concurrency_stress():
+    # The algorithms run concurrently on several threads give the same results as a single thread.
+    output = run('./bin/crossprob_bench --stress=4 --max-n=1000')
+    assert output.strip().endswith(b', 0 mismatches')
+
+def test_regression_suite():
+    # A synthetic timing baseline and results: slower samples are flagged, the same ones aren't, and so are too few samples.
+    def record(name, samples_ns, result):
+        return {'benchmark': name, 'size': 100, 'median_ns': sorted(samples_ns)[len(samples_ns)//2], 'samples_ns': samples_ns, 'result': result}
+    samples = [1000 + (17*i) % 100 for i in range(30)]
+    baseline = [record('same', samples, 0.5), record('slower', samples, 0.5), record('few', samples[:6], 0.5)]
+    results = [record('same', samples[::-1], 0.5), record('slower', [int(1.5*x) for x in samples], 0.5), record('few', samples[:5], 0.5)]
+    references = [{'benchmark': name, 'size': 100, 'result': 0.5} for name in ['same', 'slower', 'few']]
+    with tempfile.TemporaryDirectory() as directory:
+        for (filename, records) in [('baseline', baseline), ('results', results), ('references', references)]:
+            with open(directory + '/' + filename, 'w') as f:
+                json.dump(records, f)
+        output = run(f'{sys.executable} benchmarks/regression.py --results {directory}/results --baseline {directory}/baseline --references {directory}/references; true').split(b'\n')
+    assert output[1].endswith(b'ok')
+    assert output[2].endswith(b'SLOWER')
+    assert b'TOO FEW SAMPLES' in output[3]
+    assert output[4] == b'2 of 3 cases flagged.'
+
+    # The corpus up to n=1000 gives the checked-in probabilities, without a timing baseline.
+    output = run(f'{sys.executable} benchmarks/regression.py --max-n=1000 --min-time=0.001 --baseline=/nonexistent')
+    assert output.strip().endswith(b'0 of 32 cases flagged.')
+
+def import_crossprob():
+    """The python extension built by "make python", or None (skipping the test) if it or NumPy isn't available."""
+    try:
+        import numpy
+    except ImportError:
+        print('Skipping, NumPy is not installed.')
+        return None
+    sys.path[:0] = [path for path in glob.glob('build/lib*') if path not in sys.path]
+    try:
+        import crossprob
+    except ImportError:
+        print('Skipping, the python extension is not built. Run "make python" to build it.')
+        return None
+    return crossprob
+
+def ks_bounds(n, d):
+    import numpy
+    i = numpy.arange(1, n+1)
+    return (numpy.clip(i/n - d, 0, 1), numpy.clip((i-1)/n + d, 0, 1))
+
+def test_python_arrays():
+    crossprob = import_crossprob()
+    if crossprob is None:
+        return
+    import numpy
+    (b, B) = ks_bounds(200, 0.08)
+    expected = crossprob.ecdf2(list(b), list(B), True)
+    assert abs(crossprob.ecdf2_array(b, B) - expected) < 1e-12
+    # Non-contiguous columns and integer arrays are converted.
+    columns = numpy.stack([b, B], axis=1)
+    assert abs(crossprob.ecdf2_array(columns[:, 0], columns[:, 1]) - expected) < 1e-12
+    assert crossprob.ecdf1_new_B_array(numpy.ones(200, dtype=int)) == 1.0
+    assert abs(crossprob.ecdf1_new_B_array(B) - crossprob.ecdf1_new_B(list(B))) < 1e-12
+    by_count = crossprob.poisson_noncrossing_probability_by_count_array(150.0, b, B)
+    assert isinstance(by_count, numpy.ndarray) and (len(by_count) == 201)
+    assert numpy.allclose(by_count, crossprob.poisson_noncrossing_probability_by_count(150.0, list(b), list(B), True), rtol=0, atol=1e-12)
+
+    with_error = crossprob.ecdf_with_error('ecdf2-mn2017', list(b), list(B))
+    assert abs(with_error.probability - expected) <= with_error.error_bound
+    assert 0 <= with_error.error_estimate <= with_error.error_bound
+    dd = crossprob.ecdf2_dd(list(b), list(B))
+    assert abs(dd.noncrossing_probability - expected) < 1e-12
+    assert abs(dd.crossing_probability - (1 - expected)) < 1e-12
+
+def test_python_pool():
+    crossprob = import_crossprob()
+    if crossprob is None:
+        return
+    import numpy
+    bounds = [ks_bounds(300, d) for d in [0.05, 0.07, 0.1]]
+    expected = [crossprob.ecdf2(list(b), list(B), True) for (b, B) in bounds]
+    with crossprob.Pool(2, 'ecdf2-mn2017') as pool:
+        # A 2-D array with one boundary per row.
+        result = pool.map(numpy.array([b for (b, B) in bounds]), numpy.array([B for (b, B) in bounds]))
+        assert numpy.allclose(result, expected, rtol=0, atol=1e-12)
+        assert abs(pool.submit(*bounds[1]).result() - expected[1]) < 1e-12
+    # Lists of boundaries of different lengths, and one-sided boundaries.
+    bounds = [ks_bounds(n, 0.1) for n in [50, 120, 400]]
+    with crossprob.Pool(3) as pool:
+        result = pool.map([b for (b, B) in bounds], [B for (b, B) in bounds])
+        assert numpy.allclose(result, [crossprob.ecdf2(list(b), list(B), True) for (b, B) in bounds], rtol=0, atol=1e-10)
+        result = pool.map(None, [B for (b, B) in bounds])
+        assert numpy.allclose(result, [crossprob.ecdf1_new_B(list(B)) for (b, B) in bounds], rtol=0, atol=1e-10)
+
+def test_python_threads():
+    crossprob = import_crossprob()
+    if crossprob is None:
+        return
+    # The GIL is released during a long computation: the main thread keeps running meanwhile.
+    (b, B) = ks_bounds(10000, 0.012)
+    results = []
+    worker = threading.Thread(target=lambda: results.append(crossprob.ecdf2_array(b, B)))
+    iterations = 0
+    worker.start()
+    while worker.is_alive():
+        iterations += 1
+    worker.join()
+    print('Main thread iterations during the call:', iterations)
+    assert iterations > 1000
+    assert abs(results[0] - crossprob.ecdf2_array(b, B)) == 0
 
+    # Concurrent calls from several threads give the same results as sequential ones.
+    bounds = [ks_bounds(2000, d) for d in [0.02, 0.025, 0.03, 0.035]]
+    expected = [crossprob.ecdf2_array(b, B) for (b, B) in bounds]
+    results = [None]*len(bounds)
+    def compute(k):
+        results[k] = crossprob.ecdf2_array(*bounds[k])
+    threads = [threading.Thread(target=compute, args=(k,)) for k in range(len(bounds))]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert results == expected
 
 def main():
     for (key,val) in globals().items():